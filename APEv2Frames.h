@@ -18,10 +18,13 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #pragma once
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <span>
 #include <string>
+#include <string_view>
 
 namespace // anonymous
 {
@@ -48,6 +51,7 @@ class APEv2TagHeader
 public:
 
   static constexpr uint32_t kApeIDSize = 8;
+  static constexpr uint32_t kApeVersion2 = 2000;
 
 private:
 
@@ -109,6 +113,17 @@ public:
     return !!( flags_ & kFlagIsReadOnly );
   }
 
+  // Tags written by this library always have both a header and a footer
+  void SetHeader( uint32_t tagSize, uint32_t itemCount, bool isHeader )
+  {
+    memcpy( apeID_, "APETAGEX", kApeIDSize );
+    version_ = kApeVersion2;
+    tagSize_ = tagSize;
+    itemCount_ = itemCount;
+    flags_ = kFlagHasHeader | ( isHeader ? kFlagIsHeader : 0u );
+    reserved_ = 0u;
+  }
+
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -132,6 +147,9 @@ private:
 
 public:
 
+  // Value size, flags, and a one-character key with its terminator
+  static constexpr size_t kMinItemSize = sizeof( uint32_t ) + sizeof( uint32_t ) + 2u;
+
   APEv2TagItem() = default;
   APEv2TagItem( const APEv2TagItem& ) = default;
   APEv2TagItem& operator=( const APEv2TagItem& ) = delete;
@@ -145,7 +163,7 @@ public:
 
   uint32_t GetTagSize() const // bytes
   {
-    return uint32_t( sizeof(*this) + GetKey().size() + valueSize_ );
+    return uint32_t( sizeof(*this) + GetKeyView().size() + valueSize_ );
   }
 
   bool IsText() const
@@ -163,31 +181,37 @@ public:
     return !!( flags_ & kFlagIsReadOnly );
   }
 
+  uint32_t GetFlags() const
+  {
+    return flags_;
+  }
+
   std::string GetKey() const
   {
-    uint32_t charCount = 0u;
-    std::string value;
-    const char* s = key_;
-    for( ; *s != '\0'; ++s, ++charCount )
-    {
-      // Safety check
-      if( charCount == kMaxKeySize )
-      {
-        // Failure indicates malformed frame
-        assert( charCount < kMaxKeySize );
-        break;
-      }
-      value.push_back( *s );
-    }
-    return value;
+    return std::string( GetKeyView() );
+  }
+
+  std::string_view GetKeyView() const
+  {
+    return GetKeyView( kMaxKeySize + 1 );
+  }
+
+  // Key is null terminated; bound the search by the bytes left in the buffer
+  // so a malformed item can't run away. Empty if there's no terminator
+  std::string_view GetKeyView( size_t bytesLeft ) const
+  {
+    size_t searchBytes = std::min( bytesLeft, size_t( kMaxKeySize + 1 ) );
+    const auto* keyEnd = static_cast<const char*>( memchr( key_, '\0', searchBytes ) );
+    if( keyEnd == nullptr )
+      return std::string_view();
+    return std::string_view( key_, static_cast<size_t>( keyEnd - key_ ) );
   }
 
   std::span<const uint8_t> GetData() const
   {
     size_t blobBytes = static_cast<size_t>( GetValueSize() );
-    std::string value = GetKey();
-    size_t valueBytes = value.size() + sizeof( '\0' );
-    const uint8_t* blobStart = reinterpret_cast<const uint8_t*>( key_ ) + valueBytes;
+    size_t keyBytes = GetKeyView().size() + sizeof( '\0' );
+    const uint8_t* blobStart = reinterpret_cast<const uint8_t*>( key_ ) + keyBytes;
     return std::span{ blobStart, blobBytes };
   }
 
@@ -199,6 +223,24 @@ public:
     return value;
   }
 
+  static uint32_t GetItemSize( std::string_view key, size_t valueBytes )
+  {
+    // sizeof includes the key null terminator
+    return static_cast<uint32_t>( sizeof( APEv2TagItem ) + key.size() + valueBytes );
+  }
+
+  void SetItem( std::string_view key, std::span<const uint8_t> value, bool isBinary, uint32_t flags )
+  {
+    // Assumes GetItemSize() bytes allocated. Flags other than the item type
+    // are kept from the given flags, e.g. those of the item being replaced
+    assert( !key.empty() && key.size() <= kMaxKeySize );
+    valueSize_ = static_cast<uint32_t>( value.size() );
+    flags_ = ( flags & ~kFlagIsBinary ) | ( isBinary ? kFlagIsBinary : 0u );
+    memcpy( key_, key.data(), key.size() );
+    key_[ key.size() ] = '\0';
+    memcpy( key_ + key.size() + sizeof( '\0' ), value.data(), value.size() );
+  }
+
 };
 
 } // namespace PKIsensee
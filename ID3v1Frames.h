@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ID3v1Frames.h
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting 
+//  source code.
+// 
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+//  ID3v1 tag structure. Intended to be used as a "casted-to" object or copied
+//  directly from the last 128 bytes of the file, e.g.
+//  const ID3v1Tag* pTag = reinterpret_cast<const ID3v1Tag*>( pTail );
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace PKIsensee
+{
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// ID3v1 and ID3v1.1 tag
+//
+// See https://id3.org/ID3v1 and http://mpgedit.org/mpgedit/mpeg_format/mpeghdr.htm#MPEGTAG
+// ID3v1.1 stores the track number in the last byte of the comment when the
+// byte before it is zero.
+
+class ID3v1Tag
+{
+public:
+
+  static constexpr uint32_t kTagSize = 128;
+  static constexpr uint8_t  kNoGenre = 0xFF;
+
+private:
+
+  static constexpr size_t kTagIDSize = 3;
+  static constexpr size_t kTextSize = 30;
+  static constexpr size_t kYearSize = 4;
+  static constexpr size_t kTrackMarker = 28; // comment byte that must be zero for v1.1
+  static constexpr size_t kTrackPos = 29;    // comment byte holding the v1.1 track number
+
+#pragma pack(push,1) // Essential for strict binary layout of the ID3 file format
+  // Order and size must not be modified
+  char    tagID_[ kTagIDSize ] = {};  // 'TAG'
+  char    title_[ kTextSize ] = {};   // space or null padded
+  char    artist_[ kTextSize ] = {};
+  char    album_[ kTextSize ] = {};
+  char    year_[ kYearSize ] = {};    // YYYY
+  char    comment_[ kTextSize ] = {}; // v1.1: 28 chars, null, track
+  uint8_t genre_ = kNoGenre;          // index into kStaticGenreList
+#pragma pack(pop)
+
+public:
+
+  ID3v1Tag() = default;
+  ID3v1Tag( const ID3v1Tag& ) = default;
+  ID3v1Tag& operator=( const ID3v1Tag& ) = default;
+  ID3v1Tag( ID3v1Tag&& ) = default;
+  ID3v1Tag& operator=( ID3v1Tag&& ) = default;
+
+  // True if the given 128 bytes look like an ID3v1 tag
+  static bool IsTag( const uint8_t* rawTag )
+  {
+    assert( rawTag != nullptr );
+    return memcmp( rawTag, "TAG", kTagIDSize ) == 0;
+  }
+
+  void Clear()
+  {
+    *this = ID3v1Tag{};
+    memcpy( tagID_, "TAG", kTagIDSize );
+  }
+
+  std::string GetTitle() const
+  {
+    return GetField( title_, kTextSize );
+  }
+
+  std::string GetArtist() const
+  {
+    return GetField( artist_, kTextSize );
+  }
+
+  std::string GetAlbum() const
+  {
+    return GetField( album_, kTextSize );
+  }
+
+  std::string GetYear() const
+  {
+    return GetField( year_, kYearSize );
+  }
+
+  std::string GetComment() const
+  {
+    return GetField( comment_, HasTrack() ? kTrackMarker : kTextSize );
+  }
+
+  bool HasTrack() const
+  {
+    return ( comment_[ kTrackMarker ] == '\0' ) && ( comment_[ kTrackPos ] != '\0' );
+  }
+
+  uint8_t GetTrack() const // zero if not present
+  {
+    return HasTrack() ? static_cast<uint8_t>( comment_[ kTrackPos ] ) : uint8_t( 0 );
+  }
+
+  uint8_t GetGenre() const // kNoGenre if not present
+  {
+    return genre_;
+  }
+
+  void SetTitle( std::string_view title )
+  {
+    SetField( title_, kTextSize, title );
+  }
+
+  void SetArtist( std::string_view artist )
+  {
+    SetField( artist_, kTextSize, artist );
+  }
+
+  void SetAlbum( std::string_view album )
+  {
+    SetField( album_, kTextSize, album );
+  }
+
+  void SetYear( std::string_view year )
+  {
+    SetField( year_, kYearSize, year );
+  }
+
+  void SetComment( std::string_view comment )
+  {
+    uint8_t track = GetTrack();
+    SetField( comment_, kTextSize, comment );
+    if( track != 0 )
+      SetTrack( track ); // v1.1 comments are limited to 28 chars
+  }
+
+  void SetTrack( uint8_t track ) // zero removes the track, reverting to v1.0
+  {
+    comment_[ kTrackMarker ] = '\0';
+    comment_[ kTrackPos ] = static_cast<char>( track );
+  }
+
+  void SetGenre( uint8_t genre )
+  {
+    genre_ = genre;
+  }
+
+private:
+
+  static std::string GetField( const char* field, size_t maxChars )
+  {
+    // Fields are null terminated unless they use the full width; some taggers pad with spaces
+    const auto* end = static_cast<const char*>( memchr( field, '\0', maxChars ) );
+    std::string_view value( field, end ? static_cast<size_t>( end - field ) : maxChars );
+    while( !value.empty() && value.back() == ' ' )
+      value.remove_suffix( 1 );
+    return std::string( value );
+  }
+
+  static void SetField( char* field, size_t maxChars, std::string_view value )
+  {
+    // Silently truncated to fit; ID3v1 has no room for anything longer
+    size_t charCount = ( value.size() < maxChars ) ? value.size() : maxChars;
+    memset( field, 0, maxChars );
+    memcpy( field, value.data(), charCount );
+  }
+
+};
+
+static_assert( sizeof( ID3v1Tag ) == ID3v1Tag::kTagSize );
+
+} // namespace PKIsensee
+
+///////////////////////////////////////////////////////////////////////////////
@@ -18,10 +18,14 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #pragma once
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <span>
 #include <string>
+#include <string_view>
 
 #include "StrUtil.h"
 #include "Util.h"
@@ -68,6 +72,120 @@ uint32_t WriteID3Int( uint32_t nativeInt )
   return Util::ToBigEndian( result );
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Remove unsynchronization in place: every 0xFF 0x00 pair becomes 0xFF.
+// Returns the new size. memchr does the searching, since 0xFF is rare in
+// text and most binary frame data.
+
+inline size_t RemoveUnsynchronization( uint8_t* data, size_t size )
+{
+  const uint8_t* src = data;
+  const uint8_t* end = data + size;
+  uint8_t* dest = data;
+  while( src < end )
+  {
+    const auto* ff = static_cast<const uint8_t*>( memchr( src, 0xFF, static_cast<size_t>( end - src ) ) );
+    size_t runBytes = ff ? static_cast<size_t>( ff - src ) + 1 : static_cast<size_t>( end - src );
+    memmove( dest, src, runBytes );
+    dest += runBytes;
+    src += runBytes;
+    if( ff && src < end && *src == 0x00 )
+      ++src;
+  }
+  return static_cast<size_t>( dest - data );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Start of the trailing run of zero bytes, i.e. ID3v2 padding; size if there's
+// no padding. Padding can be tens of KB, so it's skipped a word at a time from
+// the end. Frames may end in zero bytes, so a frame can straddle the returned
+// offset, but no frame starts at or after it.
+
+inline size_t GetPaddingStart( const uint8_t* data, size_t size )
+{
+  size_t end = size;
+  while( end % sizeof( uint64_t ) != 0 )
+  {
+    if( data[ end - 1 ] != 0 )
+      return end;
+    --end;
+  }
+  while( end >= sizeof( uint64_t ) )
+  {
+    uint64_t word = 0u;
+    memcpy( &word, data + end - sizeof( word ), sizeof( word ) );
+    if( word != 0u )
+      break;
+    end -= sizeof( word );
+  }
+  while( end > 0 && data[ end - 1 ] == 0 )
+    --end;
+  return end;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Append frame text to out as UTF-8 without intermediate strings, so a reused
+// out doesn't allocate. Wide text is little endian UTF-16, like wchar_t
+// elsewhere; unpaired surrogates become U+FFFD. Trailing nulls, which some
+// buggy frames include, are dropped.
+
+inline void AppendDecodedText( std::string& out, std::string_view raw, bool isWide )
+{
+  if( !isWide )
+  {
+    while( !raw.empty() && raw.back() == '\0' )
+      raw.remove_suffix( 1 );
+    out.append( raw );
+    return;
+  }
+
+  auto* p = reinterpret_cast<const uint8_t*>( raw.data() );
+  size_t unitCount = raw.size() / sizeof( char16_t );
+  auto getUnit = [p]( size_t i ) { return uint32_t( p[ i * 2 ] ) | ( uint32_t( p[ i * 2 + 1 ] ) << 8 ); };
+  while( unitCount > 0 && getUnit( unitCount - 1 ) == 0 )
+    --unitCount;
+
+  for( size_t i = 0u; i < unitCount; ++i )
+  {
+    uint32_t c = getUnit( i );
+    if( c >= 0xD800 && c <= 0xDFFF )
+    {
+      uint32_t next = ( i + 1 < unitCount ) ? getUnit( i + 1 ) : 0u;
+      if( c <= 0xDBFF && next >= 0xDC00 && next <= 0xDFFF )
+      {
+        c = 0x10000 + ( ( c - 0xD800 ) << 10 ) + ( next - 0xDC00 );
+        ++i;
+      }
+      else
+        c = 0xFFFD;
+    }
+
+    if( c < 0x80 )
+      out.push_back( char( c ) );
+    else if( c < 0x800 )
+    {
+      out.push_back( char( 0xC0 | ( c >> 6 ) ) );
+      out.push_back( char( 0x80 | ( c & 0x3F ) ) );
+    }
+    else if( c < 0x10000 )
+    {
+      out.push_back( char( 0xE0 | ( c >> 12 ) ) );
+      out.push_back( char( 0x80 | ( ( c >> 6 ) & 0x3F ) ) );
+      out.push_back( char( 0x80 | ( c & 0x3F ) ) );
+    }
+    else
+    {
+      out.push_back( char( 0xF0 | ( c >> 18 ) ) );
+      out.push_back( char( 0x80 | ( ( c >> 12 ) & 0x3F ) ) );
+      out.push_back( char( 0x80 | ( ( c >> 6 ) & 0x3F ) ) );
+      out.push_back( char( 0x80 | ( c & 0x3F ) ) );
+    }
+  }
+}
+
 } // anonymous
 
 namespace PKIsensee
@@ -147,6 +265,21 @@ public:
     syncSafeSize_ = WriteID3Int<7>( newSize );
   }
 
+  void ClearFlags( uint8_t flags )
+  {
+    flags_ &= static_cast<uint8_t>( ~flags );
+  }
+
+  // Prepare an empty header for a file that doesn't have one
+  void Init( uint8_t majorVersion )
+  {
+    memcpy( id3_, kID3String, sizeof( id3_ ) );
+    majorVersion_ = majorVersion;
+    minorVersion_ = 0;
+    flags_ = 0;
+    syncSafeSize_ = 0;
+  }
+
   bool IsValid() const
   {
     if( !PK_VALID( GetHeaderID() == kID3String ) )
@@ -194,6 +327,7 @@ private:
 
   friend class ID3v2TextFrame;
   friend class ID3v2CommentFrame;
+  friend class ID3v2UserTextFrame;
 
 public:
 
@@ -287,6 +421,20 @@ private:
 
   constexpr static uint8_t kStatusReadOnly = ( 1 << 5 );
 
+  // Status flags; v2.4 moved each of the v2.3 flags down one bit
+  constexpr static uint8_t kV3StatusFlags = 0xE0; // tag alter, file alter, read only
+  constexpr static uint8_t kV4StatusFlags = 0x70;
+
+  // Format flags; see id3v2.3.0 3.3.1 and id3v2.4.0-structure 4.1.2
+  constexpr static uint8_t kV3Compressed = ( 1 << 7 );
+  constexpr static uint8_t kV3Encrypted  = ( 1 << 6 );
+  constexpr static uint8_t kV3Grouped    = ( 1 << 5 );
+  constexpr static uint8_t kV4Grouped    = ( 1 << 6 );
+  constexpr static uint8_t kV4Compressed = ( 1 << 3 );
+  constexpr static uint8_t kV4Encrypted  = ( 1 << 2 );
+  constexpr static uint8_t kV4Unsynchronized = ( 1 << 1 );
+  constexpr static uint8_t kV4DataLength = ( 1 << 0 );
+
 public:
 
   std::string GetFrameID() const
@@ -298,8 +446,20 @@ public:
   {
     // Version 3: big endian value. Other versions are syncSafe.
     assert( majorVersion >= kMajorVersionWith8BitSize );
-    return ( majorVersion == kMajorVersionWith8BitSize ) ? ReadID3Int<8>( syncSafeSize_ ) :
-                                                           ReadID3Int<7>( syncSafeSize_ );
+    return ( majorVersion == kMajorVersionWith8BitSize ) ? GetSize<kMajorVersionWith8BitSize>() :
+                                                           GetSize<kMajorVersionWith8BitSize + 1>();
+  }
+
+  // Version fixed at compile time, for frame walkers that dispatch on the
+  // version once per tag rather than once per frame
+  template <uint8_t kMajorVersion>
+  uint32_t GetSize() const
+  {
+    static_assert( kMajorVersion >= kMajorVersionWith8BitSize );
+    if constexpr( kMajorVersion == kMajorVersionWith8BitSize )
+      return ReadID3Int<8>( syncSafeSize_ );
+    else
+      return ReadID3Int<7>( syncSafeSize_ );
   }
 
   void SetHeader( const std::string& frameID, uint32_t newFrameSize, uint8_t majorVersion )
@@ -322,14 +482,92 @@ public:
     return statusMessages_ & kStatusReadOnly;
   }
 
+  // Frame ID without allocating, e.g. "UFID"
+  std::string_view GetFrameIDView() const
+  {
+    return std::string_view( frameID_, kFrameIDCharCount );
+  }
+
+  // Status flags in the high byte, format flags in the low byte
+  uint16_t GetFlags() const
+  {
+    return static_cast<uint16_t>( ( statusMessages_ << 8 ) | formatDescription_ );
+  }
+
+  // Re-encode the size field for another major version; contents are unchanged
+  void SetSize( uint32_t frameSize, uint8_t majorVersion )
+  {
+    assert( majorVersion >= kMajorVersionWith8BitSize );
+    syncSafeSize_ = ( majorVersion == kMajorVersionWith8BitSize ) ? WriteID3Int<8>( frameSize ) :
+                                                                    WriteID3Int<7>( frameSize );
+  }
+
+  // Compression, encryption, grouping etc.; bit layouts differ between versions
+  bool HasFormatFlags() const
+  {
+    return formatDescription_ != 0;
+  }
+
+  bool IsCompressed( uint8_t majorVersion ) const
+  {
+    return formatDescription_ & ( ( majorVersion == kMajorVersionWith8BitSize ) ? kV3Compressed : kV4Compressed );
+  }
+
+  bool IsEncrypted( uint8_t majorVersion ) const
+  {
+    return formatDescription_ & ( ( majorVersion == kMajorVersionWith8BitSize ) ? kV3Encrypted : kV4Encrypted );
+  }
+
+  // Compressed or encrypted; frame data can't be read in place
+  template <uint8_t kMajorVersion>
+  bool IsOpaque() const
+  {
+    constexpr uint8_t kOpaqueFlags = ( kMajorVersion == kMajorVersionWith8BitSize ) ?
+      ( kV3Compressed | kV3Encrypted ) : ( kV4Compressed | kV4Encrypted );
+    return formatDescription_ & kOpaqueFlags;
+  }
+
+  // A group ID byte precedes the frame data
+  bool IsGrouped( uint8_t majorVersion ) const
+  {
+    return formatDescription_ & ( ( majorVersion == kMajorVersionWith8BitSize ) ? kV3Grouped : kV4Grouped );
+  }
+
+  // v2.4 only; in v2.3, unsynchronization applies to the whole tag
+  bool IsUnsynchronized( uint8_t majorVersion ) const
+  {
+    return ( majorVersion > kMajorVersionWith8BitSize ) && ( formatDescription_ & kV4Unsynchronized );
+  }
+
+  // v2.4 only; a syncSafe decoded size precedes the frame data
+  bool HasDataLengthIndicator( uint8_t majorVersion ) const
+  {
+    return ( majorVersion > kMajorVersionWith8BitSize ) && ( formatDescription_ & kV4DataLength );
+  }
+
+  void ClearFormatFlags()
+  {
+    formatDescription_ = 0;
+  }
+
+  // Move the status flags to another version's bit layout. Format flags can't
+  // be converted, since the data prefixes they describe differ by version too
+  void ConvertFlags( uint8_t fromVersion, uint8_t toVersion )
+  {
+    assert( !HasFormatFlags() );
+    bool isFromV3 = ( fromVersion == kMajorVersionWith8BitSize );
+    bool isToV3 = ( toVersion == kMajorVersionWith8BitSize );
+    if( isFromV3 == isToV3 )
+      return;
+    statusMessages_ = isFromV3 ? uint8_t( ( statusMessages_ & kV3StatusFlags ) >> 1 ) :
+                                 uint8_t( ( statusMessages_ & kV4StatusFlags ) << 1 );
+  }
+
   // None of this functionality currently needed, so unimplemented
   // See https://mutagen-specs.readthedocs.io/en/latest/id3/id3v2.3.0.html
   //
   // bool PreserveFrameOnTagAlter() const
   // bool PreserveFrameOnFileAlter() const
-  // bool IsCompressed() const
-  // bool IsEncrypted() const
-  // bool IsGrouped() const
   // uint_8 GetGroupID() const
   // uint_8 GetEncryptionMethod() const
 
@@ -360,6 +598,49 @@ public:
     return textBytes;
   }
 
+protected:
+
+  // Split "description\0text" frame fields (COMM, TXXX) without copying.
+  // Removes the text BOM and any trailing nulls
+  static void SplitDescription( std::string_view fields, bool isWideString,
+                                std::string_view& description, std::string_view& text )
+  {
+    // Description and text are separated by a null character
+    size_t unitBytes = isWideString ? 2u : 1u;
+    size_t separator = std::string_view::npos;
+    if( isWideString )
+    {
+      for( size_t i = 0u; i + 1 < fields.size(); i += 2 )
+      {
+        if( fields[ i ] == '\0' && fields[ i + 1 ] == '\0' )
+        {
+          separator = i;
+          break;
+        }
+      }
+    }
+    else
+      separator = fields.find( '\0' );
+
+    description = fields.substr( 0, separator );
+    text = {};
+    if( separator != std::string_view::npos )
+      text = fields.substr( separator + unitBytes );
+
+    // Each UTF-16 string has its own BOM
+    if( isWideString && text.size() >= 2 &&
+        static_cast<uint8_t>( text[ 0 ] ) == kByteOrderMark1 &&
+        static_cast<uint8_t>( text[ 1 ] ) == kByteOrderMark0 )
+      text.remove_prefix( 2 );
+
+    // In some buggy frames, trailing null bytes may be included, so strip them out
+    if( isWideString && text.size() % 2 != 0 )
+      text.remove_suffix( 1 );
+    while( text.size() >= unitBytes && text.back() == '\0' &&
+           ( !isWideString || text[ text.size() - 2 ] == '\0' ) )
+      text.remove_suffix( unitBytes );
+  }
+
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -395,33 +676,27 @@ public:
   }
 
   std::string GetText( uint8_t majorVersion ) const
+  {
+    std::string value;
+    AppendText( majorVersion, value );
+    return value;
+  }
+
+  // Decode onto the end of out, reusing its capacity
+  void AppendText( uint8_t majorVersion, std::string& out ) const
+  {
+    AppendDecodedText( out, GetRawText( majorVersion ), IsWideString() );
+  }
+
+  // Text bytes as stored, without decoding; wide strings start after the BOM
+  std::string_view GetRawText( uint8_t majorVersion ) const
   {
     assert( majorVersion >= kMajorVersionWith8BitSize );
     if( !IsValid() )
       return {};
     bool isWideString = IsWideString();
-
-    // Determine size of string
     auto byteCount = GetTextBytes( str_, majorVersion, isWideString );
-
-    // Read data; current implementation always returns std::string for simplicity
-    std::string value;
-    if( isWideString )
-    {
-      assert( byteCount % 2 == 0 );
-      auto charCount = byteCount / sizeof( wchar_t );
-      std::wstring unicode = str_.GetTextWide( charCount );
-      value = StringUtil::GetUtf8( unicode );
-    }
-    else
-    {
-      auto charCount = byteCount / sizeof( char );
-      value = str_.GetText( charCount );
-    }
-
-    // In some buggy frames, trailing null bytes may be included, so strip them out
-    StrUtil::ToTrimmedTrailing( value, std::string( { '\0' } ) );
-    return value;
+    return { reinterpret_cast<const char*>( str_.GetTextStart( isWideString ) ), byteCount };
   }
 
   void SetText( const std::string& newText )
@@ -452,6 +727,273 @@ public:
 
 };
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Values of a multi-valued text frame, as a range of views into the frame
+//
+// ID3v2.4 separates values with nulls; v2.3 taggers conventionally use '/',
+// e.g. "Band A/Band B". Nothing is copied or decoded: for wide frames each
+// view holds raw UTF-16 bytes (little endian unless the frame is UTF16BE),
+// with any per-value BOM removed. Views are valid until the frame changes.
+
+class ID3v2TextValues
+{
+public:
+
+  class Iterator
+  {
+  private:
+
+    std::string_view remain_; // unsplit text following value_
+    std::string_view value_;
+    bool isWide_ = false;
+    bool isBigEndian_ = false;
+    bool splitOnSlash_ = false;
+    bool isEnd_ = true;
+
+    // UTF-16 code unit at pos in the frame's byte order
+    static uint16_t GetCodeUnit( std::string_view text, size_t pos, bool isBigEndian )
+    {
+      auto b0 = static_cast<uint8_t>( text[ pos ] );
+      auto b1 = static_cast<uint8_t>( text[ pos + 1 ] );
+      return isBigEndian ? uint16_t( ( b0 << 8 ) | b1 ) : uint16_t( ( b1 << 8 ) | b0 );
+    }
+
+    // Position of the next separator, or npos; for wide text, only aligned
+    // 16-bit code units are separators
+    size_t FindSeparator() const
+    {
+      if( !isWide_ )
+        return splitOnSlash_ ? remain_.find_first_of( std::string_view( "/\0", 2 ) ) :
+                               remain_.find( '\0' );
+      for( size_t i = 0u; i + 1 < remain_.size(); i += 2 )
+      {
+        if( remain_[ i + 1 ] != '\0' && remain_[ i ] != '\0' )
+          continue; // fast reject for most code units
+        uint16_t codeUnit = GetCodeUnit( remain_, i, isBigEndian_ );
+        if( codeUnit == 0u || ( splitOnSlash_ && codeUnit == '/' ) )
+          return i;
+      }
+      return std::string_view::npos;
+    }
+
+    void Trim()
+    {
+      size_t unitBytes = isWide_ ? 2u : 1u;
+      if( isWide_ && value_.size() >= 2 )
+      {
+        auto b0 = static_cast<uint8_t>( value_[ 0 ] );
+        auto b1 = static_cast<uint8_t>( value_[ 1 ] );
+        if( ( b0 == kByteOrderMark1 && b1 == kByteOrderMark0 ) || ( b0 == kByteOrderMark0 && b1 == kByteOrderMark1 ) )
+          value_.remove_prefix( 2 );
+      }
+      auto isSpace = [&]( size_t pos )
+      {
+        if( !isWide_ )
+          return value_[ pos ] == ' ';
+        return GetCodeUnit( value_, pos, isBigEndian_ ) == ' ';
+      };
+      while( value_.size() >= unitBytes && isSpace( 0 ) )
+        value_.remove_prefix( unitBytes );
+      while( value_.size() >= unitBytes && isSpace( value_.size() - unitBytes ) )
+        value_.remove_suffix( unitBytes );
+    }
+
+    void Next()
+    {
+      size_t separatorBytes = isWide_ ? 2u : 1u;
+      while( !remain_.empty() )
+      {
+        size_t pos = FindSeparator();
+        value_ = remain_.substr( 0, pos );
+        remain_ = ( pos == std::string_view::npos ) ? std::string_view{} : remain_.substr( pos + separatorBytes );
+        Trim();
+        if( !value_.empty() ) // skips empty values and trailing nulls
+          return;
+      }
+      isEnd_ = true;
+    }
+
+  public:
+
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = const std::string_view&;
+
+    Iterator() = default; // end
+
+    Iterator( std::string_view text, bool isWide, bool isBigEndian, bool splitOnSlash )
+      : remain_( text ), isWide_( isWide ), isBigEndian_( isBigEndian ), splitOnSlash_( splitOnSlash ),
+        isEnd_( false )
+    {
+      Next();
+    }
+
+    reference operator*() const
+    {
+      return value_;
+    }
+
+    pointer operator->() const
+    {
+      return &value_;
+    }
+
+    Iterator& operator++()
+    {
+      Next();
+      return *this;
+    }
+
+    Iterator operator++( int )
+    {
+      Iterator prev = *this;
+      Next();
+      return prev;
+    }
+
+    bool operator==( const Iterator& rhs ) const
+    {
+      if( isEnd_ || rhs.isEnd_ )
+        return isEnd_ == rhs.isEnd_;
+      return value_.data() == rhs.value_.data();
+    }
+  };
+
+private:
+
+  std::string_view text_;
+  bool isWide_ = false;
+  bool isBigEndian_ = false;
+  bool splitOnSlash_ = false;
+
+public:
+
+  ID3v2TextValues() = default;
+
+  // Wide text is in one byte order for the whole frame: big endian if the
+  // frame is UTF16BE, otherwise little endian
+  ID3v2TextValues( std::string_view text, bool isWide, bool isBigEndian, bool splitOnSlash )
+    : text_( text ), isWide_( isWide ), isBigEndian_( isBigEndian ), splitOnSlash_( splitOnSlash )
+  {
+  }
+
+  Iterator begin() const
+  {
+    return Iterator( text_, isWide_, isBigEndian_, splitOnSlash_ );
+  }
+
+  Iterator end() const
+  {
+    return Iterator();
+  }
+
+  bool empty() const
+  {
+    return begin() == end();
+  }
+
+  // True if each value is raw UTF-16
+  bool IsWide() const
+  {
+    return isWide_;
+  }
+
+  bool IsBigEndian() const
+  {
+    return isBigEndian_;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Fields of a comment frame as views into the frame data. Raw fields are
+// undecoded; wide fields exclude the BOM and terminator. Decoded values are
+// transcoded on demand
+
+class ID3v2CommentView
+{
+private:
+
+  std::string_view language_;    // e.g. "eng"
+  std::string_view description_; // e.g. "iTunSMPB"
+  std::string_view text_;        // comment text, trailing nulls removed
+  bool isWide_ = false;
+
+  std::string Decode( std::string_view raw ) const
+  {
+    std::string value;
+    AppendDecodedText( value, raw, isWide_ );
+    return value;
+  }
+
+public:
+
+  ID3v2CommentView() = default;
+
+  ID3v2CommentView( std::string_view language, std::string_view description,
+                    std::string_view text, bool isWide )
+    : language_( language ), description_( description ), text_( text ), isWide_( isWide )
+  {
+  }
+
+  std::string_view GetLanguage() const
+  {
+    return language_;
+  }
+
+  std::string_view GetRawDescription() const
+  {
+    return description_;
+  }
+
+  std::string_view GetRawText() const
+  {
+    return text_;
+  }
+
+  // True if raw fields are UTF-16
+  bool IsWide() const
+  {
+    return isWide_;
+  }
+
+  std::string GetDescription() const
+  {
+    return Decode( description_ );
+  }
+
+  std::string GetText() const
+  {
+    return Decode( text_ );
+  }
+
+  // Decode the text onto the end of out, reusing its capacity
+  void AppendText( std::string& out ) const
+  {
+    AppendDecodedText( out, text_, isWide_ );
+  }
+
+  // Compare the description to ASCII text without decoding
+  bool IsDescription( std::string_view ascii ) const
+  {
+    if( !isWide_ )
+      return description_ == ascii;
+    if( description_.size() != ascii.size() * 2 )
+      return false;
+    for( size_t i = 0u; i < ascii.size(); ++i )
+    {
+      uint16_t codeUnit;
+      memcpy( &codeUnit, description_.data() + ( i * 2 ), sizeof( codeUnit ) );
+      if( codeUnit != static_cast<uint8_t>( ascii[ i ] ) )
+        return false;
+    }
+    return true;
+  }
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // MP3 comment frame header
@@ -487,52 +1029,31 @@ public:
            ( textEncoding == ID3TextEncoding::UTF16BE );
   }
 
-  std::string GetText( uint8_t majorVersion ) const
+  // Split the frame into language, description and text without copying
+  ID3v2CommentView GetView( uint8_t majorVersion ) const
   {
     assert( majorVersion >= kMajorVersionWith8BitSize );
     bool isWideString = IsWideString();
-
-    // Determine size of string
     auto byteCount = GetTextBytes( str_, majorVersion, isWideString );
+    std::string_view fields( reinterpret_cast<const char*>( str_.GetTextStart( isWideString ) ), byteCount );
 
-    // Read data; current implementation always returns std::string for simplicity.
-    // Comment is made up of description text, then comment text, separated by a null byte.
-    std::string value;
-    if( isWideString )
-    {
-      assert( byteCount % 2 == 0 );
-      auto charCount = byteCount / sizeof( wchar_t );
-      std::wstring descriptionAndComment = str_.GetTextWide( charCount );
-
-      // Skip comment description
-      auto start = std::begin( descriptionAndComment );
-      auto end = start + static_cast<signed>( charCount );
-      for( ; *start++; )
-        ;
-
-      // Skip BOM
-      assert( *start == kByteOrderMark );
-      start++;
-
-      value = StringUtil::GetUtf8( std::wstring( start, end ) ); // comment text
-    }
-    else
-    {
-      auto charCount = byteCount / sizeof( char );
-      std::string descPlusComment = str_.GetText( charCount );
-
-      // Skip comment description
-      auto start = std::begin( descPlusComment );
-      auto end = start + static_cast<signed>( charCount );
-      for( ; *start++; )
-        ;
+    std::string_view description;
+    std::string_view text;
+    SplitDescription( fields, isWideString, description, text );
+    return ID3v2CommentView( std::string_view( language_, sizeof( language_ ) ),
+                             description, text, isWideString );
+  }
 
-      value.assign( start, end ); // comment text
-    }
+  std::string GetText( uint8_t majorVersion ) const
+  {
+    return GetView( majorVersion ).GetText();
+  }
 
-    // In some buggy frames, trailing null bytes may be included, so strip them out
-    StrUtil::ToTrimmedTrailing( value, std::string( { '\0' } ) );
-    return value;
+  // Description that precedes the comment text; empty for most comments, but
+  // used as a key by some applications, e.g. "iTunSMPB"
+  std::string GetDescription( uint8_t majorVersion ) const
+  {
+    return GetView( majorVersion ).GetDescription();
   }
 
   static uint32_t GetFrameSize( const std::string& newComment )
@@ -556,6 +1077,76 @@ public:
   }
 };
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// MP3 user-defined text frame header
+// 
+// See https://mutagen-specs.readthedocs.io/en/latest/id3/id3v2.4.0-frames.html#user-defined-text-information-frame
+
+// TXXX fields are a comment without the language
+using ID3v2UserTextView = ID3v2CommentView;
+
+class ID3v2UserTextFrame : public ID3v2FrameHdr // 'TXXX' header
+{
+private:
+
+#pragma pack(push,1) // Essential for strict binary layout of the ID3 file format
+  // Order and size must not be modified
+  uint8_t       textEncoding_;  // see TextEncoding IDs above
+  ID3v2String   str_;           // contains both description and value
+#pragma pack(pop)
+
+public:
+
+  ID3v2UserTextFrame() = delete; // only used as a casted-to object
+
+  ID3TextEncoding GetTextEncoding() const
+  {
+    assert( textEncoding_ <= static_cast<uint8_t>( ID3TextEncoding::Max ) );
+    return static_cast< ID3TextEncoding >( textEncoding_ );
+  }
+
+  bool IsWideString() const
+  {
+    auto textEncoding = GetTextEncoding();
+    return ( textEncoding == ID3TextEncoding::UTF16 ) ||
+           ( textEncoding == ID3TextEncoding::UTF16BE );
+  }
+
+  // Split the frame into description and value without copying
+  ID3v2UserTextView GetView( uint8_t majorVersion ) const
+  {
+    assert( majorVersion >= kMajorVersionWith8BitSize );
+    bool isWideString = IsWideString();
+    auto byteCount = GetTextBytes( str_, majorVersion, isWideString );
+    std::string_view fields( reinterpret_cast<const char*>( str_.GetTextStart( isWideString ) ), byteCount );
+
+    std::string_view description;
+    std::string_view value;
+    SplitDescription( fields, isWideString, description, value );
+    return ID3v2UserTextView( {}, description, value, isWideString );
+  }
+
+  static uint32_t GetFrameSize( const std::string& description, const std::string& value )
+  {
+    auto size = sizeof( ID3v2UserTextFrame );
+    size -= sizeof( ID3v2String ); // don't include faux string disambiguator
+
+    // Create ANSI frames for simplicity, like text frames
+    size += description.size() + sizeof( '\0' );
+    size += value.size();
+    return static_cast<uint32_t>( size );
+  }
+
+  void SetText( const std::string& description, const std::string& value )
+  {
+    textEncoding_ = static_cast<uint8_t>( ID3TextEncoding::ANSI );
+    memcpy( str_.utf8_, description.c_str(), description.size() );
+    str_.utf8_[ description.size() ] = '\0';
+    memcpy( str_.utf8_ + description.size() + sizeof( '\0' ), value.c_str(), value.size() );
+  }
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // MP3 private frame header
@@ -0,0 +1,429 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  ID3v2Timeline.h
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+//  Time-indexed ID3v2 frames: synchronized lyrics/text (SYLT) and chapters
+//  (CHAP/CTOC). Each is decoded once into a compact array sorted by time, so
+//  lookups during playback are binary searches.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ID3v2Frames.h"
+
+namespace PKIsensee
+{
+
+namespace // anonymous
+{
+
+static constexpr const char* kChapterTitleFrameID = "TIT2";
+static constexpr size_t      kLanguageCharCount = 3;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Timestamps and offsets in SYLT, CHAP and CTOC are plain big endian ints
+
+inline uint32_t ReadTimelineInt32( const uint8_t* p )
+{
+  uint32_t sourceInt;
+  memcpy( &sourceInt, p, sizeof( sourceInt ) );
+  return ReadID3Int<8>( sourceInt );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Read a null-terminated string in the given encoding as UTF-8 and advance
+// past the terminator. A missing terminator ends the string at the end of the
+// data. UTF-16 strings carry their own BOM; UTF16BE strings have none.
+
+inline bool ReadTimelineString( std::span<const uint8_t>& data, ID3TextEncoding textEncoding,
+                                std::string& value )
+{
+  value.clear();
+  if( data.empty() )
+    return false;
+
+  if( textEncoding != ID3TextEncoding::UTF16 && textEncoding != ID3TextEncoding::UTF16BE )
+  {
+    const auto* end = static_cast<const uint8_t*>( memchr( data.data(), '\0', data.size() ) );
+    size_t byteCount = end ? static_cast<size_t>( end - data.data() ) : data.size();
+    value.assign( reinterpret_cast<const char*>( data.data() ), byteCount );
+    data = data.subspan( std::min( byteCount + 1, data.size() ) );
+    return true;
+  }
+
+  bool isBigEndian = ( textEncoding == ID3TextEncoding::UTF16BE );
+  size_t i = 0u;
+  if( data.size() >= 2 && textEncoding == ID3TextEncoding::UTF16 )
+  {
+    if( data[ 0 ] == kByteOrderMark0 && data[ 1 ] == kByteOrderMark1 )
+    {
+      isBigEndian = true;
+      i = 2;
+    }
+    else if( data[ 0 ] == kByteOrderMark1 && data[ 1 ] == kByteOrderMark0 )
+      i = 2;
+  }
+
+  std::wstring unicode;
+  for( ; i + 1 < data.size(); i += 2 )
+  {
+    auto codeUnit = isBigEndian ? uint16_t( ( data[ i ] << 8 ) | data[ i + 1 ] ) :
+                                  uint16_t( ( data[ i + 1 ] << 8 ) | data[ i ] );
+    if( codeUnit == 0u )
+    {
+      i += 2;
+      break;
+    }
+    unicode.push_back( static_cast<wchar_t>( codeUnit ) );
+  }
+  value = StringUtil::GetUtf8( unicode );
+  data = data.subspan( std::min( i, data.size() ) );
+  return true;
+}
+
+} // anonymous
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Synchronized lyrics or text (SYLT)
+//
+// See https://mutagen-specs.readthedocs.io/en/latest/id3/id3v2.4.0-frames.html#synchronised-lyrics-text
+//
+// Text of all entries is stored back to back in one UTF-8 buffer; each entry
+// is a start time and a slice of that buffer. Text for an entry is shown from
+// its time until the next entry's time.
+
+class ID3v2SyncedText
+{
+public:
+
+  enum class ContentType : uint8_t
+  {
+    Other = 0,
+    Lyrics = 1,
+    Transcription = 2,
+    Movement = 3,     // e.g. "Adagio"
+    Events = 4,       // e.g. "Don Quijote enters the stage"
+    Chord = 5,        // e.g. "Bb F Fsus"
+    Trivia = 6,
+    WebPageUrls = 7,
+    ImageUrls = 8
+  };
+
+private:
+
+  static constexpr uint8_t kTimeFormatMpegFrames = 1;
+  static constexpr uint8_t kTimeFormatMs = 2;
+  static constexpr size_t  kFixedFieldBytes = 6; // encoding, language, time format, content type
+
+  struct Entry
+  {
+    uint32_t timeMs = 0u;
+    uint32_t textOffset = 0u; // into text_
+    uint32_t textBytes = 0u;
+  };
+
+  std::vector<Entry> entries_; // sorted by timeMs
+  std::string text_;
+  std::string language_;
+  std::string description_;
+  ContentType contentType_ = ContentType::Other;
+
+public:
+
+  ID3v2SyncedText() = default;
+
+  // Language code of a SYLT payload, e.g. "eng", without decoding the frame
+  static std::string_view GetLanguage( std::span<const uint8_t> payload )
+  {
+    if( payload.size() < kFixedFieldBytes )
+      return {};
+    return std::string_view( reinterpret_cast<const char*>( payload.data() + 1 ), kLanguageCharCount );
+  }
+
+  // Decode a SYLT payload. Timestamps in MPEG frames are converted to
+  // milliseconds, which requires the stream's sample rate and frame length
+  bool Parse( std::span<const uint8_t> payload, uint32_t sampleRate, uint32_t samplesPerFrame )
+  {
+    *this = ID3v2SyncedText{};
+    if( payload.size() < kFixedFieldBytes )
+      return false;
+
+    auto textEncoding = static_cast<ID3TextEncoding>( payload[ 0 ] );
+    if( payload[ 0 ] >= static_cast<uint8_t>( ID3TextEncoding::Max ) )
+      return false;
+    uint8_t timeFormat = payload[ 4 ];
+    if( timeFormat != kTimeFormatMs && timeFormat != kTimeFormatMpegFrames )
+      return false;
+    if( timeFormat == kTimeFormatMpegFrames && sampleRate == 0u )
+      return false;
+
+    language_ = GetLanguage( payload );
+    contentType_ = static_cast<ContentType>( payload[ 5 ] );
+    auto data = payload.subspan( kFixedFieldBytes );
+    ReadTimelineString( data, textEncoding, description_ );
+
+    // Entries are text followed by a 32-bit timestamp
+    std::string value;
+    while( ReadTimelineString( data, textEncoding, value ) && data.size() >= sizeof( uint32_t ) )
+    {
+      uint64_t time = ReadTimelineInt32( data.data() );
+      data = data.subspan( sizeof( uint32_t ) );
+      if( timeFormat == kTimeFormatMpegFrames )
+        time = time * samplesPerFrame * 1000u / sampleRate;
+
+      Entry entry;
+      entry.timeMs = static_cast<uint32_t>( std::min<uint64_t>( time, UINT32_MAX ) );
+      entry.textOffset = static_cast<uint32_t>( text_.size() );
+      entry.textBytes = static_cast<uint32_t>( value.size() );
+      entries_.push_back( entry );
+      text_ += value;
+    }
+
+    // Entries should already be in time order, but that isn't guaranteed
+    std::ranges::stable_sort( entries_, {}, &Entry::timeMs );
+    return !entries_.empty();
+  }
+
+  bool IsEmpty() const
+  {
+    return entries_.empty();
+  }
+
+  size_t GetEntryCount() const
+  {
+    return entries_.size();
+  }
+
+  uint32_t GetTimeMs( size_t i ) const
+  {
+    assert( i < entries_.size() );
+    return entries_[ i ].timeMs;
+  }
+
+  std::string_view GetText( size_t i ) const
+  {
+    assert( i < entries_.size() );
+    return std::string_view( text_ ).substr( entries_[ i ].textOffset, entries_[ i ].textBytes );
+  }
+
+  std::string_view GetLanguage() const
+  {
+    return language_;
+  }
+
+  const std::string& GetDescription() const
+  {
+    return description_;
+  }
+
+  ContentType GetContentType() const
+  {
+    return contentType_;
+  }
+
+  // Entry showing at the given time; empty before the first entry
+  std::optional<size_t> FindEntry( uint32_t timeMs ) const
+  {
+    auto it = std::ranges::upper_bound( entries_, timeMs, {}, &Entry::timeMs );
+    if( it == entries_.begin() )
+      return std::nullopt;
+    return static_cast<size_t>( it - entries_.begin() ) - 1;
+  }
+
+  std::string_view GetTextAt( uint32_t timeMs ) const
+  {
+    auto i = FindEntry( timeMs );
+    return i ? GetText( *i ) : std::string_view{};
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Chapters (CHAP) and the top-level table of contents (CTOC)
+//
+// See https://mutagen-specs.readthedocs.io/en/latest/id3/id3v2-chapters-1.0.html
+//
+// Chapters are sorted by start time. The element IDs and titles of all
+// chapters share one UTF-8 buffer.
+
+class ID3v2Chapters
+{
+private:
+
+  static constexpr size_t  kChapterTimeBytes = 16; // start/end time, start/end offset
+  static constexpr uint8_t kTocTopLevel = 0x02;
+
+  struct Entry
+  {
+    uint32_t startMs = 0u;
+    uint32_t endMs = 0u;
+    uint32_t idOffset = 0u;    // into text_
+    uint32_t idBytes = 0u;
+    uint32_t titleOffset = 0u; // into text_
+    uint32_t titleBytes = 0u;
+  };
+
+  std::vector<Entry> entries_; // sorted by startMs
+  std::string text_;
+  std::string title_;          // from the TIT2 sub-frame of the top-level CTOC
+
+  // Title from the embedded sub-frames of a CHAP or CTOC frame
+  static std::string ReadTitle( std::span<const uint8_t> subFrames, uint8_t majorVersion )
+  {
+    while( subFrames.size() > sizeof( ID3v2FrameHdr ) )
+    {
+      const auto* frameHdr = reinterpret_cast<const ID3v2FrameHdr*>( subFrames.data() );
+      size_t frameBytes = sizeof( ID3v2FrameHdr ) + frameHdr->GetSize( majorVersion );
+      if( frameBytes > subFrames.size() )
+        break;
+      if( frameHdr->GetFrameIDView() == kChapterTitleFrameID )
+      {
+        const auto* textFrame = reinterpret_cast<const ID3v2TextFrame*>( subFrames.data() );
+        return textFrame->IsValid() ? textFrame->GetText( majorVersion ) : std::string();
+      }
+      subFrames = subFrames.subspan( frameBytes );
+    }
+    return std::string();
+  }
+
+public:
+
+  ID3v2Chapters() = default;
+
+  void Clear()
+  {
+    *this = ID3v2Chapters{};
+  }
+
+  // Decode a CHAP payload; call SortByTime() once all chapters are added
+  bool AddChapter( std::span<const uint8_t> payload, uint8_t majorVersion )
+  {
+    std::string elementID;
+    if( !ReadTimelineString( payload, ID3TextEncoding::ANSI, elementID ) )
+      return false;
+    if( payload.size() < kChapterTimeBytes )
+      return false;
+
+    std::string title = ReadTitle( payload.subspan( kChapterTimeBytes ), majorVersion );
+    Entry entry;
+    entry.startMs = ReadTimelineInt32( payload.data() );
+    entry.endMs = ReadTimelineInt32( payload.data() + sizeof( uint32_t ) );
+    entry.idOffset = static_cast<uint32_t>( text_.size() );
+    entry.idBytes = static_cast<uint32_t>( elementID.size() );
+    entry.titleOffset = entry.idOffset + entry.idBytes;
+    entry.titleBytes = static_cast<uint32_t>( title.size() );
+    entries_.push_back( entry );
+    text_ += elementID;
+    text_ += title;
+    return true;
+  }
+
+  // Decode a CTOC payload; only the top-level table's title is kept, since
+  // chapters are ordered by time regardless of the order the table lists
+  bool AddTableOfContents( std::span<const uint8_t> payload, uint8_t majorVersion )
+  {
+    std::string elementID;
+    if( !ReadTimelineString( payload, ID3TextEncoding::ANSI, elementID ) )
+      return false;
+    if( payload.size() < 2 )
+      return false;
+    uint8_t flags = payload[ 0 ];
+    uint8_t entryCount = payload[ 1 ];
+    payload = payload.subspan( 2 );
+    for( uint8_t i = 0u; i < entryCount; ++i )
+    {
+      if( !ReadTimelineString( payload, ID3TextEncoding::ANSI, elementID ) )
+        return false;
+    }
+    if( flags & kTocTopLevel )
+      title_ = ReadTitle( payload, majorVersion );
+    return true;
+  }
+
+  void SortByTime()
+  {
+    std::ranges::stable_sort( entries_, {}, &Entry::startMs );
+  }
+
+  bool IsEmpty() const
+  {
+    return entries_.empty();
+  }
+
+  size_t GetChapterCount() const
+  {
+    return entries_.size();
+  }
+
+  uint32_t GetStartMs( size_t i ) const
+  {
+    assert( i < entries_.size() );
+    return entries_[ i ].startMs;
+  }
+
+  uint32_t GetEndMs( size_t i ) const
+  {
+    assert( i < entries_.size() );
+    return entries_[ i ].endMs;
+  }
+
+  // Element ID, e.g. "chp0"
+  std::string_view GetID( size_t i ) const
+  {
+    assert( i < entries_.size() );
+    return std::string_view( text_ ).substr( entries_[ i ].idOffset, entries_[ i ].idBytes );
+  }
+
+  std::string_view GetTitle( size_t i ) const
+  {
+    assert( i < entries_.size() );
+    return std::string_view( text_ ).substr( entries_[ i ].titleOffset, entries_[ i ].titleBytes );
+  }
+
+  // Title of the whole table of contents; often empty
+  const std::string& GetTitle() const
+  {
+    return title_;
+  }
+
+  // Chapter containing the given time. Chapters may leave gaps; a chapter
+  // whose end isn't after its start runs until the next chapter
+  std::optional<size_t> FindChapter( uint32_t timeMs ) const
+  {
+    auto it = std::ranges::upper_bound( entries_, timeMs, {}, &Entry::startMs );
+    if( it == entries_.begin() )
+      return std::nullopt;
+    --it;
+    if( it->endMs > it->startMs && timeMs >= it->endMs )
+      return std::nullopt;
+    return static_cast<size_t>( it - entries_.begin() );
+  }
+};
+
+} // namespace PKIsensee
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,750 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Mp3AudioData.cpp
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting
+//  source code.
+//
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+//  Mp3TagData members that deal with the MPEG audio between the ID3v2 section
+//  and the APE/ID3v1 tail.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <future>
+#include <thread>
+
+#if defined( __linux__ )
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+
+#include "File.h"
+#include "Log.h"
+#include "Mp3TagData.h"
+#include "Util.h"
+
+using namespace PKIsensee;
+
+namespace // anonymous
+{
+
+constexpr uint32_t kAudioProbeSize = 16 * 1024; // junk, info frame and a few audio frames
+constexpr uint32_t kFramesToValidate = 3;       // consecutive matching headers required
+constexpr uint32_t kMinFrameHdrBytes = 4;
+constexpr uint32_t kScanChunkSize = 64 * 1024;  // frame header scan read size
+constexpr uint32_t kHashChunkSize = 1024 * 1024; // audio hash read size
+constexpr uint32_t kCopyChunkSize = 1024 * 1024; // audio copy read/write size when the kernel can't copy
+constexpr uint64_t kKernelCopyMax = 1024 * 1024 * 1024; // bytes per copy_file_range/sendfile call
+constexpr const char* kiTunesGaplessDesc = "iTunSMPB";
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Find the first frame header followed by a run of compatible headers. A lone
+// sync pattern in junk data or album art is common, so one header isn't proof.
+
+const uint8_t* FindFirstFrame( const uint8_t* begin, const uint8_t* end )
+{
+  for( const uint8_t* p = FindMpegSync( begin, end ); p != nullptr; p = FindMpegSync( p + 1, end ) )
+  {
+    if( end - p < kMinFrameHdrBytes )
+      return nullptr;
+    MpegFrameHdr first( p );
+    if( !first.IsValid() )
+      continue;
+
+    bool isValid = true;
+    const uint8_t* next = p;
+    MpegFrameHdr hdr = first;
+    for( uint32_t i = 1u; i < kFramesToValidate; ++i )
+    {
+      next += hdr.GetFrameBytes();
+      if( end - next < kMinFrameHdrBytes )
+        break; // end of the probe; accept the frames validated so far
+      hdr = MpegFrameHdr( next );
+      if( !hdr.IsValid() || !hdr.IsCompatible( first ) )
+      {
+        isValid = false;
+        break;
+      }
+    }
+    if( isValid )
+      return p;
+  }
+  return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Streaming XXH64 (https://github.com/Cyan4973/xxHash), seed 0
+//
+// Hashes at several GB/s per core, so hashing keeps up with sequential reads.
+// Input words are read little endian; big endian hosts would need a bswap.
+
+class AudioHasher
+{
+private:
+
+  static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+  static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+  static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+  static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+  static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+  static constexpr size_t   kStripeSize = 32;
+
+  uint64_t acc_[ 4 ] = { kPrime1 + kPrime2, kPrime2, 0u, 0u - kPrime1 };
+  uint8_t  stripe_[ kStripeSize ] = {};
+  size_t   stripeBytes_ = 0u;
+  uint64_t totalBytes_ = 0u;
+
+  static uint64_t Read64( const uint8_t* p )
+  {
+    uint64_t value;
+    memcpy( &value, p, sizeof( value ) );
+    return value;
+  }
+
+  static uint32_t Read32( const uint8_t* p )
+  {
+    uint32_t value;
+    memcpy( &value, p, sizeof( value ) );
+    return value;
+  }
+
+  static uint64_t Round( uint64_t acc, uint64_t input )
+  {
+    acc += input * kPrime2;
+    return std::rotl( acc, 31 ) * kPrime1;
+  }
+
+  static uint64_t Merge( uint64_t hash, uint64_t acc )
+  {
+    hash ^= Round( 0u, acc );
+    return hash * kPrime1 + kPrime4;
+  }
+
+  void ConsumeStripe( const uint8_t* p )
+  {
+    acc_[ 0 ] = Round( acc_[ 0 ], Read64( p ) );
+    acc_[ 1 ] = Round( acc_[ 1 ], Read64( p + 8 ) );
+    acc_[ 2 ] = Round( acc_[ 2 ], Read64( p + 16 ) );
+    acc_[ 3 ] = Round( acc_[ 3 ], Read64( p + 24 ) );
+  }
+
+public:
+
+  void Update( const uint8_t* data, size_t size )
+  {
+    totalBytes_ += size;
+    if( stripeBytes_ != 0u )
+    {
+      size_t fill = std::min( size, kStripeSize - stripeBytes_ );
+      memcpy( stripe_ + stripeBytes_, data, fill );
+      stripeBytes_ += fill;
+      data += fill;
+      size -= fill;
+      if( stripeBytes_ < kStripeSize )
+        return;
+      ConsumeStripe( stripe_ );
+      stripeBytes_ = 0u;
+    }
+    for( ; size >= kStripeSize; data += kStripeSize, size -= kStripeSize )
+      ConsumeStripe( data );
+    memcpy( stripe_, data, size );
+    stripeBytes_ = size;
+  }
+
+  uint64_t GetHash() const
+  {
+    uint64_t hash = kPrime5;
+    if( totalBytes_ >= kStripeSize )
+    {
+      hash = std::rotl( acc_[ 0 ], 1 ) + std::rotl( acc_[ 1 ], 7 ) +
+             std::rotl( acc_[ 2 ], 12 ) + std::rotl( acc_[ 3 ], 18 );
+      for( uint64_t acc : acc_ )
+        hash = Merge( hash, acc );
+    }
+    hash += totalBytes_;
+
+    const uint8_t* p = stripe_;
+    const uint8_t* end = stripe_ + stripeBytes_;
+    for( ; end - p >= 8; p += 8 )
+      hash = std::rotl( hash ^ Round( 0u, Read64( p ) ), 27 ) * kPrime1 + kPrime4;
+    if( end - p >= 4 )
+    {
+      hash = std::rotl( hash ^ ( Read32( p ) * kPrime1 ), 23 ) * kPrime2 + kPrime3;
+      p += 4;
+    }
+    for( ; p < end; ++p )
+      hash = std::rotl( hash ^ ( *p * kPrime5 ), 11 ) * kPrime1;
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+  }
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copy a byte range from one file to another inside the kernel, so the data
+// never passes through user space. Uses copy_file_range, or sendfile where that
+// can't cross file systems. Returns the bytes copied; fewer than byteCount
+// means the caller must copy the rest. Windows has no equivalent for arbitrary
+// file ranges: TransmitFile needs a socket, and block cloning needs cluster
+// aligned offsets, which the audio start rarely is
+
+uint64_t CopyRangeInKernel( const std::filesystem::path& srcPath, uint64_t srcOffset,
+                            const std::filesystem::path& destPath, uint64_t destOffset,
+                            uint64_t byteCount )
+{
+#if defined( __linux__ )
+  int src = open( srcPath.c_str(), O_RDONLY | O_CLOEXEC );
+  if( src < 0 )
+    return 0u;
+  int dest = open( destPath.c_str(), O_WRONLY | O_CLOEXEC );
+  if( dest < 0 )
+  {
+    close( src );
+    return 0u;
+  }
+
+  auto srcPos = static_cast<off_t>( srcOffset );
+  auto destPos = static_cast<off_t>( destOffset );
+  bool useSendFile = false;
+  uint64_t copied = 0u;
+  while( copied < byteCount )
+  {
+    auto request = static_cast<size_t>( std::min( byteCount - copied, kKernelCopyMax ) );
+    ssize_t bytes = 0;
+    if( !useSendFile )
+    {
+      bytes = copy_file_range( src, &srcPos, dest, &destPos, request, 0u );
+      if( bytes < 0 && ( errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP ) )
+      {
+        // sendfile writes at the destination file position
+        useSendFile = ( lseek( dest, destPos, SEEK_SET ) == destPos );
+        if( useSendFile )
+          continue;
+      }
+    }
+    else
+    {
+      bytes = sendfile( dest, src, &srcPos, request );
+      if( bytes > 0 )
+        destPos += bytes;
+    }
+
+    if( bytes < 0 && errno == EINTR )
+      continue;
+    if( bytes <= 0 )
+      break;
+    copied += static_cast<uint64_t>( bytes );
+  }
+
+  close( dest );
+  close( src );
+  return copied;
+#else
+  ( void )srcPath; ( void )srcOffset; ( void )destPath; ( void )destOffset; ( void )byteCount;
+  return 0u;
+#endif
+}
+
+} // end anonymous namespace
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Determine the audio format and duration from the start of the MPEG stream
+//
+// Only the first kAudioProbeSize bytes after the ID3v2 section are read. The
+// frame count comes from the Xing/Info or VBRI header when the encoder wrote
+// one, which makes the duration exact; otherwise the stream is assumed to be
+// CBR and the duration is estimated from the audio size.
+
+bool Mp3TagData::LoadAudioInfo()
+{
+  audioInfo_ = MpegAudioInfo{};
+  if( audioEndOffset_ <= audioBufferOffset_ )
+    return false;
+
+  File mp3File( path_ );
+  if( !mp3File.Open( FileFlags::Read | FileFlags::SharedRead ) )
+    return false;
+
+  auto probeSize = static_cast<uint32_t>( std::min<uint64_t>( kAudioProbeSize,
+                                                              audioEndOffset_ - audioBufferOffset_ ) );
+  std::vector<uint8_t> probe( probeSize );
+  uint32_t bytesRead = 0u;
+  if( !mp3File.SetPos( audioBufferOffset_ ) || !mp3File.Read( probe.data(), probeSize, bytesRead ) )
+  {
+    PKLOG_WARN( "Failed to read MPEG audio from %S; ERR: %d\n", path_.c_str(), Util::GetLastError() );
+    return false;
+  }
+  mp3File.Close();
+
+  const uint8_t* begin = probe.data();
+  const uint8_t* end = begin + bytesRead;
+  const uint8_t* frame = FindFirstFrame( begin, end );
+  if( frame == nullptr )
+  {
+    PKLOG_WARN( "\nNo MPEG audio frames found in %S\n", path_.c_str() );
+    return false;
+  }
+
+  MpegFrameHdr hdr( frame );
+  MpegAudioInfo& info = audioInfo_;
+  info.version = hdr.GetVersion();
+  info.layer = hdr.GetLayer();
+  info.sampleRate = hdr.GetSampleRate();
+  info.channelMode = hdr.GetChannelMode();
+  info.samplesPerFrame = hdr.GetSamplesPerFrame();
+  info.firstFrameOffset = audioBufferOffset_ + static_cast<uint64_t>( frame - begin );
+  info.audioBytes = audioEndOffset_ - info.firstFrameOffset;
+
+  // Informational headers only appear in Layer III streams
+  bool hasInfoFrame = false;
+  uint32_t frameCount = 0u;
+  uint32_t byteCount = 0u;
+  auto available = static_cast<uint32_t>( end - frame );
+  if( info.layer == 3 )
+  {
+    uint32_t xingOffset = hdr.GetXingOffset();
+    if( xingOffset < available )
+      info.xing = MpegXingHdr( frame + xingOffset, available - xingOffset );
+    if( info.xing.IsValid() )
+    {
+      hasInfoFrame = true;
+      info.isVbr = info.xing.IsVbr();
+      frameCount = info.xing.HasFrameCount() ? info.xing.GetFrameCount() : 0u;
+      byteCount = info.xing.HasByteCount() ? info.xing.GetByteCount() : 0u;
+
+      uint32_t lameOffset = xingOffset + info.xing.GetHeaderBytes();
+      if( lameOffset < available )
+        info.lame = MpegLameHdr( frame + lameOffset, available - lameOffset );
+      if( info.lame.IsValid() )
+        info.encoder = info.lame.GetEncoder();
+    }
+    else if( hdr.GetVbriOffset() < available )
+    {
+      MpegVbriHdr vbri( frame + hdr.GetVbriOffset(), available - hdr.GetVbriOffset() );
+      if( vbri.IsValid() )
+      {
+        hasInfoFrame = true;
+        info.isVbr = true;
+        frameCount = vbri.GetFrameCount();
+        byteCount = vbri.GetByteCount();
+      }
+    }
+  }
+
+  // The info frame holds no audio
+  if( hasInfoFrame )
+  {
+    uint32_t infoFrameBytes = std::min<uint32_t>( hdr.GetFrameBytes(), static_cast<uint32_t>( info.audioBytes ) );
+    info.firstFrameOffset += infoFrameBytes;
+    info.audioBytes -= infoFrameBytes;
+  }
+
+  if( frameCount )
+  {
+    info.isExact = true;
+    info.frameCount = frameCount;
+    uint64_t sampleCount = uint64_t( frameCount ) * info.samplesPerFrame;
+    info.durationMs = sampleCount * 1000u / info.sampleRate;
+    uint64_t streamBytes = byteCount ? byteCount : info.audioBytes;
+    if( info.durationMs )
+      info.bitrate = static_cast<uint32_t>( streamBytes * 8u / info.durationMs ); // bits/ms == kbps
+  }
+  else
+  {
+    info.bitrate = hdr.GetBitrate();
+    info.durationMs = info.audioBytes * 8u / info.bitrate;
+    info.frameCount = static_cast<uint32_t>( info.durationMs * info.sampleRate /
+                                             ( 1000u * uint64_t( info.samplesPerFrame ) ) );
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Audio stream summary; valid after LoadAudioInfo() succeeds
+
+const MpegAudioInfo& Mp3TagData::GetAudioInfo() const
+{
+  return audioInfo_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Build a time-to-byte seek table for the audio stream
+
+bool Mp3TagData::BuildSeekTable( bool preferToc, uint32_t framesPerEntry )
+{
+  seekTable_ = MpegSeekTable{};
+  if( audioInfo_.sampleRate == 0u && !LoadAudioInfo() )
+    return false;
+
+  // The TOC is only meaningful when the duration it's scaled by is exact
+  if( preferToc && audioInfo_.xing.HasToc() && audioInfo_.isExact )
+  {
+    seekTable_.InitFromToc( audioInfo_.firstFrameOffset, audioInfo_.audioBytes,
+                            audioInfo_.durationMs, audioInfo_.xing );
+    return true;
+  }
+  return ScanSeekTable( framesPerEntry ? framesPerEntry : MpegSeekTable::kDefaultFramesPerEntry );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Restore a table from MpegSeekTable::Serialize(); call LoadAudioInfo() first
+
+bool Mp3TagData::SetSeekTable( std::span<const uint8_t> serializedTable )
+{
+  MpegSeekTable seekTable;
+  if( !seekTable.Deserialize( serializedTable ) )
+    return false;
+  if( !seekTable.IsMatch( audioInfo_.firstFrameOffset, audioInfo_.audioBytes ) )
+    return false;
+  seekTable_ = std::move( seekTable );
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Seek table; empty until BuildSeekTable() or SetSeekTable() succeeds
+
+const MpegSeekTable& Mp3TagData::GetSeekTable() const
+{
+  return seekTable_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Walk every frame header from the first audio frame to the tail tags
+//
+// Only headers are examined, but frames are too small to skip with seeks, so
+// the audio is read sequentially in large chunks. Damaged frames are skipped by
+// resynchronizing on the next header compatible with the first frame.
+
+bool Mp3TagData::ScanSeekTable( uint32_t framesPerEntry )
+{
+  const uint64_t streamStart = audioInfo_.firstFrameOffset;
+  const uint64_t streamEnd = streamStart + audioInfo_.audioBytes;
+
+  File mp3File( path_ );
+  if( !mp3File.Open( FileFlags::Read | FileFlags::SharedRead | FileFlags::SequentialScan ) )
+    return false;
+
+  std::vector<uint8_t> chunk( kScanChunkSize );
+  MpegFrameHdr firstHdr;
+  MpegSeekTable seekTable;
+  seekTable.InitScan( streamStart, audioInfo_.audioBytes, audioInfo_.sampleRate,
+                      audioInfo_.samplesPerFrame, framesPerEntry );
+
+  uint32_t frameCount = 0u;
+  uint64_t chunkPos = streamStart;
+  while( streamEnd - chunkPos >= kMinFrameHdrBytes )
+  {
+    auto chunkSize = static_cast<uint32_t>( std::min<uint64_t>( kScanChunkSize, streamEnd - chunkPos ) );
+    uint32_t bytesRead = 0u;
+    if( !mp3File.SetPos( chunkPos ) || !mp3File.Read( chunk.data(), chunkSize, bytesRead ) )
+    {
+      PKLOG_WARN( "Failed to read MPEG audio from %S; ERR: %d\n", path_.c_str(), Util::GetLastError() );
+      return false;
+    }
+
+    const uint8_t* begin = chunk.data();
+    const uint8_t* end = begin + bytesRead;
+    const uint8_t* p = begin;
+    while( end - p >= kMinFrameHdrBytes )
+    {
+      MpegFrameHdr hdr( p );
+      if( frameCount == 0u )
+        firstHdr = hdr;
+      if( !hdr.IsValid() || !hdr.IsCompatible( firstHdr ) )
+      {
+        p = FindMpegSync( p + 1, end );
+        if( p == nullptr )
+          p = end - ( kMinFrameHdrBytes - 1 ); // sync may straddle the chunk boundary
+        continue;
+      }
+      if( frameCount % framesPerEntry == 0u )
+        seekTable.AddEntry( static_cast<uint32_t>( chunkPos + uint64_t( p - begin ) - streamStart ) );
+      ++frameCount;
+      p += hdr.GetFrameBytes(); // may land beyond this chunk
+    }
+
+    if( p == begin ) // a short read made no progress
+      break;
+    chunkPos += uint64_t( p - begin );
+  }
+
+  if( frameCount == 0u )
+    return false;
+  seekTable.SetFrameCount( frameCount );
+  seekTable_ = std::move( seekTable );
+
+  // Every frame was counted, so the duration is now exact
+  if( !audioInfo_.isExact )
+  {
+    audioInfo_.isExact = true;
+    audioInfo_.frameCount = frameCount;
+    audioInfo_.durationMs = seekTable_.GetDurationMs();
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Hash of the audio payload alone, from GetAudioBufferOffset() to
+// GetAudioEndOffset(). Editing tags doesn't change it, so equal hashes identify
+// duplicate recordings regardless of how they're tagged
+
+bool Mp3TagData::GetAudioHash( uint64_t& hash ) const
+{
+  return HashFileRange( path_, audioBufferOffset_, audioEndOffset_, hash );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Hash the audio payload of many files in parallel
+
+std::vector<std::optional<uint64_t>> Mp3TagData::GetAudioHashes(
+  std::span<const std::filesystem::path> paths, uint32_t maxThreads ) // static
+{
+  std::vector<std::optional<uint64_t>> hashes( paths.size() );
+  if( maxThreads == 0u )
+    maxThreads = std::max( 1u, std::thread::hardware_concurrency() );
+  size_t threadCount = std::min<size_t>( maxThreads, paths.size() );
+
+  // Workers pull the next file from a shared index, so a few large files don't
+  // leave the other threads idle
+  std::atomic<size_t> nextPath = 0u;
+  auto hashFiles = [&]
+  {
+    for( size_t i = nextPath++; i < paths.size(); i = nextPath++ )
+    {
+      // Files with no tags at all are hashed too; the entire file is the audio
+      Mp3TagData tagData;
+      if( !tagData.LocateAudio( paths[ i ] ) )
+        continue;
+      uint64_t hash = 0u;
+      if( tagData.GetAudioHash( hash ) )
+        hashes[ i ] = hash;
+    }
+  };
+
+  std::vector<std::future<void>> workers;
+  workers.reserve( threadCount );
+  for( size_t i = 0u; i < threadCount; ++i )
+    workers.push_back( std::async( std::launch::async, hashFiles ) );
+  for( auto& worker : workers )
+    worker.wait();
+  return hashes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Hash [start, end) of the file with large sequential reads
+
+bool Mp3TagData::HashFileRange( const std::filesystem::path& path, uint64_t start, uint64_t end,
+                                uint64_t& hash ) // static
+{
+  File mp3File( path );
+  if( !mp3File.Open( FileFlags::Read | FileFlags::SharedRead | FileFlags::SequentialScan ) )
+    return false;
+  if( !mp3File.SetPos( start ) )
+    return false;
+
+  AudioHasher hasher;
+  std::vector<uint8_t> chunk( static_cast<size_t>( std::min<uint64_t>( kHashChunkSize, end - start ) ) );
+  for( uint64_t pos = start; pos < end; )
+  {
+    auto chunkSize = static_cast<uint32_t>( std::min<uint64_t>( chunk.size(), end - pos ) );
+    uint32_t bytesRead = 0u;
+    if( !mp3File.Read( chunk.data(), chunkSize, bytesRead ) || bytesRead == 0u )
+    {
+      PKLOG_WARN( "Failed to read MPEG audio from %S; ERR: %d\n", path.c_str(), Util::GetLastError() );
+      return false;
+    }
+    hasher.Update( chunk.data(), bytesRead );
+    pos += bytesRead;
+  }
+  hash = hasher.GetHash();
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Determine encoder delay and padding for gapless playback. Found info is
+// kept until the tags are reloaded, so repeated calls are free
+
+bool Mp3TagData::LoadGaplessInfo()
+{
+  if( gaplessInfo_.source != Mp3GaplessSource::None )
+    return true;
+
+  Mp3GaplessInfo gaplessInfo;
+  if( GetiTunesGaplessInfo( gaplessInfo ) )
+  {
+    gaplessInfo_ = gaplessInfo;
+    return true;
+  }
+
+  if( audioInfo_.sampleRate == 0u && !LoadAudioInfo() )
+    return false;
+  if( !audioInfo_.lame.IsValid() )
+    return false;
+
+  gaplessInfo.encoderDelay = audioInfo_.lame.GetEncoderDelay();
+  gaplessInfo.encoderPadding = audioInfo_.lame.GetEncoderPadding();
+  gaplessInfo.source = Mp3GaplessSource::LameHeader;
+  if( audioInfo_.isExact )
+  {
+    uint64_t totalSamples = uint64_t( audioInfo_.frameCount ) * audioInfo_.samplesPerFrame;
+    uint64_t trimSamples = uint64_t( gaplessInfo.encoderDelay ) + gaplessInfo.encoderPadding;
+    gaplessInfo.sampleCount = ( totalSamples > trimSamples ) ? totalSamples - trimSamples : 0u;
+  }
+  gaplessInfo_ = gaplessInfo;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Gapless information; valid after LoadGaplessInfo() succeeds
+
+const Mp3GaplessInfo& Mp3TagData::GetGaplessInfo() const
+{
+  return gaplessInfo_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Parse the iTunSMPB comment written by iTunes and other AAC/MP3 encoders
+//
+// The comment is a list of space-separated hex fields:
+// " 00000000 00000210 000003C0 0000000000A1B2C0 00000000 ..."
+// reserved, encoder delay, padding, sample count, then fields we don't need
+
+bool Mp3TagData::GetiTunesGaplessInfo( Mp3GaplessInfo& gaplessInfo ) const
+{
+  auto comment = FindComment( kiTunesGaplessDesc );
+  if( !comment )
+    return false;
+
+  constexpr size_t kFieldCount = 4;
+  uint64_t fields[ kFieldCount ] = {};
+  std::string smpb = comment->GetText();
+  const char* p = smpb.data();
+  const char* end = p + smpb.size();
+  size_t fieldCount = 0u;
+  for( ; fieldCount < kFieldCount; ++fieldCount )
+  {
+    while( p < end && *p == ' ' )
+      ++p;
+    auto [ next, ec ] = std::from_chars( p, end, fields[ fieldCount ], 16 );
+    if( ec != std::errc{} )
+      break;
+    p = next;
+  }
+  if( fieldCount < kFieldCount )
+  {
+    PKLOG_WARN( "\nMalformed iTunSMPB comment in %S\n", path_.c_str() );
+    return false;
+  }
+
+  gaplessInfo.encoderDelay = static_cast<uint32_t>( fields[ 1 ] );
+  gaplessInfo.encoderPadding = static_cast<uint32_t>( fields[ 2 ] );
+  gaplessInfo.sampleCount = fields[ 3 ];
+  gaplessInfo.source = Mp3GaplessSource::iTunSMPB;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copy the audio payload to a new file, optionally with a fresh ID3v2 tag
+//
+// The audio is copied by the kernel where possible. Otherwise, or for whatever
+// the kernel didn't copy, it goes through File in large sequential chunks.
+// std::filesystem::copy_file isn't an option, since the source range doesn't
+// start at offset zero. A partially written destination is removed.
+
+bool Mp3TagData::WriteAudioCopy( const std::filesystem::path& destPath, bool withID3v2Tag ) const
+{
+  std::error_code ec;
+  if( std::filesystem::equivalent( path_, destPath, ec ) )
+  {
+    PKLOG_WARN( "\nAudio copy of %S would overwrite the source\n", path_.c_str() );
+    return false;
+  }
+
+  File srcFile( path_ );
+  if( !srcFile.Open( FileFlags::Read | FileFlags::SharedRead | FileFlags::SequentialScan ) )
+    return false;
+  File destFile( destPath );
+  if( !destFile.Create( FileFlags::Write | FileFlags::SequentialScan ) )
+  {
+    PKLOG_WARN( "Failed to create %S; ERR: %d\n", destPath.c_str(), Util::GetLastError() );
+    return false;
+  }
+
+  auto removeDest = [&]()
+  {
+    PKLOG_WARN( "Failed to copy audio from %S to %S; ERR: %d\n", path_.c_str(), destPath.c_str(),
+                Util::GetLastError() );
+    destFile.Close();
+    std::filesystem::remove( destPath, ec );
+    return false;
+  };
+
+  uint64_t tagBytes = 0u;
+  if( withID3v2Tag && GetID3FrameSectionSize() != 0u )
+  {
+    std::vector<uint8_t> id3Tag;
+    SerializeID3Tag( 0u, id3Tag );
+    if( !destFile.Write( id3Tag.data(), static_cast<uint32_t>( id3Tag.size() ) ) )
+      return removeDest();
+    tagBytes = id3Tag.size();
+  }
+
+  // The kernel copy works on its own handles, so the tag must be flushed first
+  destFile.Close();
+  uint64_t audioBytes = audioEndOffset_ - audioBufferOffset_;
+  uint64_t copied = CopyRangeInKernel( path_, audioBufferOffset_, destPath, tagBytes, audioBytes );
+  if( copied == audioBytes )
+    return true;
+
+  // Copy the rest through user space
+  if( !destFile.Open( FileFlags::Write | FileFlags::SequentialScan ) ||
+      !destFile.SetPos( tagBytes + copied ) || !srcFile.SetPos( audioBufferOffset_ + copied ) )
+    return removeDest();
+  std::vector<uint8_t> chunk( static_cast<size_t>( std::min<uint64_t>( kCopyChunkSize, audioBytes - copied ) ) );
+  for( uint64_t pos = audioBufferOffset_ + copied; pos < audioEndOffset_; )
+  {
+    auto chunkSize = static_cast<uint32_t>( std::min<uint64_t>( chunk.size(), audioEndOffset_ - pos ) );
+    uint32_t bytesRead = 0u;
+    if( !srcFile.Read( chunk.data(), chunkSize, bytesRead ) || bytesRead == 0u ||
+        !destFile.Write( chunk.data(), bytesRead ) )
+      return removeDest();
+    pos += bytesRead;
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
@@ -15,7 +15,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #pragma once
+#include <optional>
 #include <string>
+#include <string_view>
 
 #include "..\frozen\unordered_map.h"
 #include "Id3v2Frames.h"
@@ -88,12 +90,57 @@ inline Mp3FrameType& operator++( Mp3FrameType& frameType )
   return frameType = static_cast<Mp3FrameType>( static_cast<int>( frameType ) + 1 );
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// ASCII case-insensitive hash and equality, e.g. for APE keys and genre names.
+// The hash is FNV-1a over lowercased characters; the seed lets frozen search
+// for a perfect hash at compile time. Transparent, so std::string keys can be
+// found by std::string_view
+
+constexpr char ToLowerAscii( char c )
+{
+  return ( c >= 'A' && c <= 'Z' ) ? static_cast<char>( c + ( 'a' - 'A' ) ) : c;
+}
+
+struct CaseInsensitiveHash
+{
+  using is_transparent = void;
+
+  constexpr size_t operator()( std::string_view str, size_t seed = 0u ) const noexcept
+  {
+    uint64_t hash = 14695981039346656037ull ^ seed;
+    for( char c : str )
+    {
+      hash ^= static_cast<uint8_t>( ToLowerAscii( c ) );
+      hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>( hash );
+  }
+};
+
+struct CaseInsensitiveEqual
+{
+  using is_transparent = void;
+
+  constexpr bool operator()( std::string_view lhs, std::string_view rhs ) const noexcept
+  {
+    if( lhs.size() != rhs.size() )
+      return false;
+    for( size_t i = 0u; i < lhs.size(); ++i )
+    {
+      if( ToLowerAscii( lhs[ i ] ) != ToLowerAscii( rhs[ i ] ) )
+        return false;
+    }
+    return true;
+  }
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // See Mp3GenreList.cpp for full list
 
 constexpr size_t kMaxGenre = 125;
-extern const char* kStaticGenreList[ kMaxGenre + 1 ];
+extern const char* const kStaticGenreList[ kMaxGenre + 1 ];
 
 ///////////////////////////////////////////////////////////////////////////////
 //
@@ -137,10 +184,20 @@ public:
   // Extract genre name from index
   static constexpr const char* GetGenre( size_t n )
   {
-    assert( n < kMaxGenre );
+    assert( n <= kMaxGenre );
     return kStaticGenreList[ n ];
   }
 
+  // Index of a genre name, ignoring case, e.g. "hip-hop" -> 7; a single
+  // compile-time perfect hash probe
+  static std::optional<uint8_t> FindGenre( std::string_view genreName );
+
+  // Resolve a TCON value to display text. Handles ID3v1 references "(21)" and
+  // "21", refinements "(4)Eurodisco" (the refinement wins), "(RX)" Remix and
+  // "(CR)" Cover, "((" escapes, and v2.4 null-separated values. Multiple
+  // genres are joined with '/'
+  static std::string ResolveGenre( std::string_view tcon );
+
   ///////////////////////////////////////////////////////////////////////////////
   //
   // True if incoming buffer looks like a typical MP3 frame
@@ -150,11 +207,8 @@ public:
     if( rawFrame == nullptr )
       return false;
 
-    // This case could happen if we're into ID3v2 padding territory
-    if( *rawFrame == 0 )
-      return false;
-
-    return Mp3BaseTagData::IsValidFrameID( GetFrameID(rawFrame) );
+    // Padding fails the frameID check on its first byte
+    return Mp3BaseTagData::IsValidFrameID( rawFrame );
   }
 
   ///////////////////////////////////////////////////////////////////////////////
@@ -166,23 +220,41 @@ public:
     // Must be 4 characters, alphanumeric and uppercase
     if( frameID.size() != kFrameIDCharCount )
       return false;
+    return IsValidFrameID( reinterpret_cast<const uint8_t*>( frameID.data() ) );
+  }
+
+  static bool IsValidFrameID( const uint8_t* frameID )
+  {
+    assert( frameID != nullptr );
+    uint32_t id = 0u;
+    memcpy( &id, frameID, kFrameIDCharCount );
+    return IsValidFrameID( id );
+  }
+
+  // All four characters are range checked at once within a 32-bit word. For a
+  // byte below 0x80, adding (0x80 - lo) sets its high bit iff byte >= lo, and
+  // adding (0x7F - hi) sets it iff byte > hi; neither carries into the next
+  // byte. Byte order doesn't matter.
+
+  static constexpr bool IsValidFrameID( uint32_t frameID )
+  {
+    constexpr uint32_t kOnes = 0x01010101u;
+    constexpr uint32_t kHighBits = 0x80808080u;
+    if( frameID & kHighBits )
+      return false;
 
-    for( auto c : frameID )
+    auto inRange = [frameID]( uint32_t lo, uint32_t hi )
     {
-      // ASCII table excerpt: "0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-      if( c < '0' || c > 'Z' ) // outside of range
-        return false;
-      if( c > '9' && c < 'A' ) // inside ":;<=>?@"
-        return false;
-    }
-    return true;
+      return ( frameID + ( 0x80u - lo ) * kOnes ) & ~( frameID + ( 0x7Fu - hi ) * kOnes ) & kHighBits;
+    };
+    return ( inRange( '0', '9' ) | inRange( 'A', 'Z' ) ) == kHighBits;
   }
 
   ///////////////////////////////////////////////////////////////////////////////
   //
   // True if the indicated frame represents a text frame, e.g. "Txxx"
 
-  static bool IsTextFrame( Mp3FrameType frameType )
+  static constexpr bool IsTextFrame( Mp3FrameType frameType )
   {
     assert( frameType < Mp3FrameType::Max );
     return IsTextFrame( kMp3FrameID.at( frameType ) );
@@ -193,7 +265,7 @@ public:
     return IsTextFrame( frameID.c_str() );
   }
 
-  static bool IsTextFrame( const char* frameID )
+  static constexpr bool IsTextFrame( const char* frameID )
   {
     assert( frameID != nullptr );
     return *frameID == 'T';
@@ -208,7 +280,13 @@ public:
     return IsCommentFrame( frameID.c_str() );
   }
 
-  static bool IsCommentFrame( const char* frameID )
+  static constexpr bool IsCommentFrame( Mp3FrameType frameType )
+  {
+    assert( frameType < Mp3FrameType::Max );
+    return IsCommentFrame( kMp3FrameID.at( frameType ) );
+  }
+
+  static constexpr bool IsCommentFrame( const char* frameID )
   {
     assert( frameID != nullptr );
     return *frameID == 'C';
@@ -235,6 +313,15 @@ public:
     return kMp3FrameID.at( frameType );
   }
 
+  // Compile-time variant; no lookup or allocation at the call site
+
+  template <Mp3FrameType kFrameType>
+  static constexpr std::string_view GetFrameID()
+  {
+    static_assert( kFrameType > Mp3FrameType::None && kFrameType < Mp3FrameType::Max );
+    return kMp3FrameID.at( kFrameType );
+  }
+
   ///////////////////////////////////////////////////////////////////////////////
   //
   // Convert frameID string to frame type
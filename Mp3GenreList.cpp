@@ -14,6 +14,9 @@
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <array>
+#include <charconv>
+
 #include "Mp3BaseTagData.h"
 
 namespace PKIsensee
@@ -23,7 +26,7 @@ namespace PKIsensee
 //
 // ID3v1 genre list (http://mpgedit.org/mpgedit/mpeg_format/mpeghdr.htm#MPEGTAG)
 
-const char* kStaticGenreList[ kMaxGenre + 1 ] =
+constexpr const char* kStaticGenreList[ kMaxGenre + 1 ] =
 {
   "Blues",                // 0
   "Classic Rock",
@@ -153,6 +156,123 @@ const char* kStaticGenreList[ kMaxGenre + 1 ] =
   "Dance Hall"            // 125
 };
 
+namespace // anonymous
+{
+
+constexpr size_t kGenreCount = kMaxGenre + 1;
+using GenreEntries = std::array<std::pair<std::string_view, uint8_t>, kGenreCount>;
+
+constexpr GenreEntries MakeGenreEntries()
+{
+  GenreEntries entries{};
+  for( size_t i = 0u; i < kGenreCount; ++i )
+    entries[ i ] = { kStaticGenreList[ i ], static_cast<uint8_t>( i ) };
+  return entries;
+}
+
+// Genre name -> kStaticGenreList index, built at compile time
+constexpr auto kGenreIndex =
+  frozen::make_unordered_map<std::string_view, uint8_t, kGenreCount, CaseInsensitiveHash, CaseInsensitiveEqual>(
+    MakeGenreEntries() );
+
+// Resolve a single reference, e.g. "21", "RX" or "CR"; empty if unknown
+std::string_view ResolveGenreRef( std::string_view genreRef )
+{
+  if( genreRef == "RX" )
+    return "Remix";
+  if( genreRef == "CR" )
+    return "Cover";
+  size_t index = 0u;
+  auto [ end, ec ] = std::from_chars( genreRef.data(), genreRef.data() + genreRef.size(), index );
+  if( ec != std::errc{} || end != genreRef.data() + genreRef.size() || index > kMaxGenre )
+    return {};
+  return kStaticGenreList[ index ];
+}
+
+std::string_view Trim( std::string_view text )
+{
+  while( !text.empty() && text.front() == ' ' )
+    text.remove_prefix( 1 );
+  while( !text.empty() && ( text.back() == ' ' || text.back() == '\0' ) )
+    text.remove_suffix( 1 );
+  return text;
+}
+
+} // end anonymous namespace
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Reverse genre lookup
+
+std::optional<uint8_t> Mp3BaseTagData::FindGenre( std::string_view genreName ) // static
+{
+  auto it = kGenreIndex.find( genreName );
+  if( it == kGenreIndex.end() )
+    return std::nullopt;
+  return it->second;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Resolve TCON references
+//
+// See https://mutagen-specs.readthedocs.io/en/latest/id3/id3v2.3.0.html#tcon
+// and https://mutagen-specs.readthedocs.io/en/latest/id3/id3v2.4.0-frames.html#tcon
+
+std::string Mp3BaseTagData::ResolveGenre( std::string_view tcon ) // static
+{
+  std::string genres;
+  auto append = [ &genres ]( std::string_view genre )
+  {
+    if( genre.empty() )
+      return;
+    if( !genres.empty() )
+      genres += '/';
+    genres += genre;
+  };
+
+  // v2.4 separates multiple values with nulls; v2.3 has a single value
+  while( !tcon.empty() )
+  {
+    size_t separator = tcon.find( '\0' );
+    std::string_view value = tcon.substr( 0, separator );
+    tcon = ( separator == std::string_view::npos ) ? std::string_view{} : tcon.substr( separator + 1 );
+
+    // Leading references, e.g. "(51)(39)"; "((" begins literal text
+    constexpr size_t kMaxGenreRefs = 8;
+    std::array<std::string_view, kMaxGenreRefs> refs;
+    size_t refCount = 0u;
+    while( value.size() > 1 && value.front() == '(' )
+    {
+      if( value[ 1 ] == '(' )
+      {
+        value.remove_prefix( 1 );
+        break;
+      }
+      size_t close = value.find( ')' );
+      if( close == std::string_view::npos )
+        break;
+      if( refCount < kMaxGenreRefs )
+        refs[ refCount++ ] = ResolveGenreRef( value.substr( 1, close - 1 ) );
+      value.remove_prefix( close + 1 );
+    }
+
+    // A refinement replaces the references; a bare value may itself be a reference
+    std::string_view text = Trim( value );
+    if( !text.empty() )
+    {
+      std::string_view genre = ResolveGenreRef( text );
+      append( genre.empty() ? text : genre );
+    }
+    else
+    {
+      for( size_t i = 0u; i < refCount; ++i )
+        append( refs[ i ] );
+    }
+  }
+  return genres;
+}
+
 } // namespace PKIsensee
 
 ///////////////////////////////////////////////////////////////////////////////
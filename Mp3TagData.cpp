@@ -15,8 +15,10 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <algorithm>
+#include <charconv>
 #include <future>
 #include <limits>
+#include <numeric>
 #include <ranges>
 
 #include "APEv2Frames.h"
@@ -36,27 +38,126 @@ using namespace PKIsensee;
 namespace // anonymous
 {
 
-constexpr size_t   kInvalidFramePos = size_t( -1 );
 constexpr size_t   kPaddingBytes = 2048u; // commonly used in MP3 tagging software
-constexpr uint64_t kBacktrackBufferSize = 4096u;  // chunk size of APE header search
+constexpr uint64_t kTailWindowSize = 4096u;  // single read at end of file for APE/ID3v1 tags
 constexpr uint64_t kNoApeHeader = uint64_t( -1 );
 static constexpr const char* kApeTag = "APETAGEX";
 
+// Conventional APE item keys for each frame type; empty if there's no equivalent
+// See https://mutagen-specs.readthedocs.io/en/latest/apev2/apev2.html#item-key
+constexpr frozen::unordered_map< Mp3FrameType, const char*, kMaxFrameTypes >
+kApeItemKey =
+{
+  { Mp3FrameType::None,           ""                },
+  { Mp3FrameType::Title,          "Title"           },
+  { Mp3FrameType::Subtitle,       "Subtitle"        },
+  { Mp3FrameType::Genre,          "Genre"           },
+  { Mp3FrameType::Artist,         "Artist"          },
+  { Mp3FrameType::Album,          "Album"           },
+  { Mp3FrameType::Composer,       "Composer"        },
+  { Mp3FrameType::Orchestra,      "Album Artist"    },
+  { Mp3FrameType::OrigArtist,     "Original Artist" },
+  { Mp3FrameType::Year,           "Year"            },
+  { Mp3FrameType::OrigYear,       "Original Year"   },
+  { Mp3FrameType::TrackNum,       "Track"           },
+  { Mp3FrameType::BeatsPerMinute, "BPM"             },
+  { Mp3FrameType::Duration,       ""                },
+  { Mp3FrameType::Key,            "Initial Key"     },
+  { Mp3FrameType::Conductor,      "Conductor"       },
+  { Mp3FrameType::Language,       "Language"        },
+  { Mp3FrameType::Mood,           "Mood"            },
+  { Mp3FrameType::Comment,        "Comment"         }
+};
+
+// Frame write order for Mp3FrameOrder::CommonFirst: the most frequently read
+// frames lead, so readers find them in the first few KB of the file, and bulky
+// binary frames trail. All other frames keep their relative order in between.
+constexpr std::array<std::string_view, 5> kLeadingFrameIDs = { "TIT2", "TPE1", "TALB", "TRCK", "TCON" };
+constexpr std::array<std::string_view, 3> kTrailingFrameIDs = { "APIC", "GEOB", "PRIV" };
+
+size_t GetFrameWriteRank( std::string_view frameID )
+{
+  for( size_t i = 0u; i < kLeadingFrameIDs.size(); ++i )
+  {
+    if( frameID == kLeadingFrameIDs[ i ] )
+      return i;
+  }
+  bool isTrailing = std::ranges::find( kTrailingFrameIDs, frameID ) != kTrailingFrameIDs.end();
+  return kLeadingFrameIDs.size() + ( isTrailing ? 1u : 0u );
+}
+
+// Frame types parsed by ParseNumericField()
+constexpr std::array<Mp3FrameType, 5> kNumericFrameTypes =
+{
+  Mp3FrameType::TrackNum, Mp3FrameType::Year, Mp3FrameType::OrigYear,
+  Mp3FrameType::BeatsPerMinute, Mp3FrameType::Duration
+};
+
+// Parse an unsigned number at the start of text, skipping leading spaces
+const char* ParseNumber( const char* p, const char* end, uint32_t& value )
+{
+  while( p < end && *p == ' ' )
+    ++p;
+  auto [ next, ec ] = std::from_chars( p, end, value );
+  return ( ec == std::errc{} ) ? next : nullptr;
+}
+
 } // end anonymous namespace
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// Read tags into memory
+// Constructor
+
+Mp3TagData::Mp3TagData()
+{
+  ClearIndexes();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Read tags into memory; fails if the file has no tags at all
 
 bool Mp3TagData::LoadTagData( const std::filesystem::path& path )
+{
+  if( !LocateAudio( path ) )
+    return false;
+
+  // An ID3v2 header always precedes the audio
+  if( audioBufferOffset_ == 0u && !hasID3v1_ && apeStart_ == kNoApeHeader )
+  {
+    PKLOG_WARN( "\nInvalid MP3 file %S; no ID3v2, ID3v1 or APE tags\n", path_.c_str() );
+    return false;
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Read tags into memory and find the bounds of the audio payload. Unlike
+// LoadTagData(), a file without tags succeeds; its audio is the whole file
+
+bool Mp3TagData::LocateAudio( const std::filesystem::path& path )
 {
   path_ = path;
   id3FrameBuffer_.resize( 0 );
   apeFrameBuffer_.resize( 0 );
   frames_.resize( 0 );
-  textFrames_.resize( 0 );
+  apeTags_.resize( 0 );
   commentFrames_.resize( 0 );
+  commentIndex_.clear();
+  userTextIndex_.clear();
+  apeIndex_.clear();
+  ClearIndexes();
+  apeStart_ = kNoApeHeader;
+  audioEndOffset_ = 0u;
+  hasID3v1_ = false;
+  audioInfo_ = MpegAudioInfo{};
+  seekTable_ = MpegSeekTable{};
+  gaplessInfo_ = Mp3GaplessInfo{};
+  syncedText_ = ID3v2SyncedText{};
+  chapters_.Clear();
   isDirty_ = false;
+  isTailDirty_ = false;
 
   File mp3File( path_ );
   if( !mp3File.Open( FileFlags::Read | FileFlags::SharedRead | FileFlags::SequentialScan ) )
@@ -69,36 +170,39 @@ bool Mp3TagData::LoadTagData( const std::filesystem::path& path )
     return false;
   };
 
-  if( !IsValidFileHeader() )
-    return false;
-
-  auto frameSectionSize = fileHeader_.GetSize();
-  assert( frameSectionSize < ( 1024 * 1024 ) ); // ensure reasonable
-  audioBufferOffset_ = sizeof( fileHeader_ ) + frameSectionSize;
-
-  // Read all ID3 frames into memory
-  id3FrameBuffer_.resize( frameSectionSize );
-  uint32_t bytesRead;
-  if( !mp3File.Read( id3FrameBuffer_.data(), frameSectionSize, bytesRead ) )
+  // Legacy files may only have ID3v1 and/or APE tags, in which case audio starts
+  // at the top of the file. A fresh header is prepared in case ID3v2 frames are added.
+  uint32_t frameSectionSize = 0u;
+  uint32_t bytesRead = 0u;
+  bool hasID3v2Header = ( fileHeader_.GetHeaderID() == kID3String );
+  if( hasID3v2Header )
   {
-    PKLOG_WARN( "Failed to read ID3 frames from %S; ERR: %d\n", path_.c_str(), Util::GetLastError() );
-    return false;
-  }
+    if( !IsValidFileHeader() )
+      return false;
 
-  // Search for APE tag
-  uint64_t apeStart = FindApeHeaderOffset( mp3File );
-  if( apeStart != kNoApeHeader )
-  {
-    uint32_t apeHeaderBytes = static_cast<uint32_t>( mp3File.GetLength() - apeStart );
-    std::vector<uint8_t> apeBuffer_;
-    apeFrameBuffer_.resize( apeHeaderBytes );
-    if( !mp3File.SetPos( apeStart ) || 
-        !mp3File.Read( apeFrameBuffer_.data(), apeHeaderBytes, bytesRead ) )
+    frameSectionSize = fileHeader_.GetSize();
+    assert( frameSectionSize < ( 1024 * 1024 ) ); // ensure reasonable
+    audioBufferOffset_ = sizeof( fileHeader_ ) + frameSectionSize;
+    if( fileHeader_.GetFlags() & ID3v2FileHeader::kFlagFooterPresent )
+      audioBufferOffset_ += sizeof( fileHeader_ ); // v2.4 footer is a copy of the header
+
+    // Read all ID3 frames into memory
+    id3FrameBuffer_.resize( frameSectionSize );
+    if( !mp3File.Read( id3FrameBuffer_.data(), frameSectionSize, bytesRead ) )
     {
-      PKLOG_WARN( "Failed to read APE tags from %S; ERR: %d\n", path_.c_str(), Util::GetLastError() );
+      PKLOG_WARN( "Failed to read ID3 frames from %S; ERR: %d\n", path_.c_str(), Util::GetLastError() );
       return false;
     }
   }
+  else
+  {
+    fileHeader_.Init( kMajorVersionWith8BitSize );
+    audioBufferOffset_ = 0u;
+  }
+
+  // APE and ID3v1 tags share a single read of the end of the file
+  if( !LoadTail( mp3File ) )
+    return false;
 
   // Close the file asynchronously while we parse the frames from memory)
   std::future fileClose = std::async( std::launch::async, [&] { mp3File.Close(); } );
@@ -114,14 +218,86 @@ bool Mp3TagData::LoadTagData( const std::filesystem::path& path )
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// Extract the MP3 tag string for the given text frame type
+// Extract the MP3 tag string for the given text frame type. Doesn't fill the
+// cache, so concurrent calls on the same object are safe
 
 std::string Mp3TagData::GetText( Mp3FrameType frameType ) const
+{
+  std::string text;
+  GetText( frameType, text );
+  return text;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Decoded text is cached per frame type until the field changes
+
+const std::string& Mp3TagData::GetTextRef( Mp3FrameType frameType ) const
+{
+  assert( IsTextFrame( frameType ) );
+  auto& cachedText = textCache_[ static_cast<size_t>( frameType ) ];
+  if( !cachedText )
+    cachedText = DecodeText( frameType );
+  return *cachedText;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Decode into caller-owned buffers; uses the cache if it's already filled but
+// doesn't fill it
+
+void Mp3TagData::GetText( Mp3FrameType frameType, std::string& out ) const
+{
+  out.clear();
+  AppendText( frameType, out );
+}
+
+size_t Mp3TagData::AppendText( Mp3FrameType frameType, std::string& out ) const
+{
+  assert( IsTextFrame( frameType ) );
+  size_t startSize = out.size();
+  if( const auto& cachedText = textCache_[ static_cast<size_t>( frameType ) ]; cachedText )
+    out.append( *cachedText );
+  else if( const ID3Frame* pFrame = GetTextFrame( frameType ); pFrame != nullptr )
+  {
+    const auto* textFrame = reinterpret_cast<const ID3v2TextFrame*>( pFrame->GetData() );
+    textFrame->AppendText( fileHeader_.GetMajorVersion(), out );
+  }
+  else
+    out.append( GetID3v1Text( frameType ) ); // empty if no ID3v1 tag either
+  return out.size() - startSize;
+}
+
+void Mp3TagData::GetComment( size_t i, std::string& out ) const
+{
+  out.clear();
+  AppendComment( i, out );
+}
+
+size_t Mp3TagData::AppendComment( size_t i, std::string& out ) const
+{
+  assert( i < commentFrames_.size() );
+  if( i >= commentFrames_.size() )
+    return 0u;
+
+  size_t startSize = out.size();
+  if( i < commentCache_.size() && commentCache_[ i ] )
+    out.append( *commentCache_[ i ] );
+  else
+    GetCommentView( i ).AppendText( out );
+  return out.size() - startSize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Decode a text frame, falling back to ID3v1
+
+std::string Mp3TagData::DecodeText( Mp3FrameType frameType ) const
 {
   assert( IsTextFrame( frameType ) );
   const ID3Frame* pFrame = GetTextFrame(frameType);
   if( pFrame == nullptr )
-    return std::string();
+    return GetID3v1Text( frameType ); // empty if no ID3v1 tag either
 
   const auto* rawFrame = pFrame->GetData();
   const auto* textFrame = reinterpret_cast<const ID3v2TextFrame*>( rawFrame );
@@ -140,19 +316,379 @@ size_t Mp3TagData::GetCommentCount() const
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// MP3 files can have multiple comments; returns the comment at the given position
+// MP3 files can have multiple comments; returns the comment at the given position.
+// Like GetText(), doesn't fill the cache
 // See https://mutagen-specs.readthedocs.io/en/latest/id3/id3v2.2.html#comments
 
 std::string Mp3TagData::GetComment(size_t i) const
+{
+  std::string comment;
+  GetComment( i, comment );
+  return comment;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Decoded comments are cached by position until comments are added or removed
+
+const std::string& Mp3TagData::GetCommentRef( size_t i ) const
 {
   assert( i < commentFrames_.size() );
   if( i >= commentFrames_.size() )
-    return std::string();
+  {
+    static const std::string kNoComment;
+    return kNoComment;
+  }
+
+  commentCache_.resize( commentFrames_.size() );
+  auto& cachedComment = commentCache_[ i ];
+  if( !cachedComment )
+    cachedComment = GetCommentView( i ).GetText();
+  return *cachedComment;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Comment fields without decoding
+
+ID3v2CommentView Mp3TagData::GetCommentView( size_t i ) const
+{
+  assert( i < commentFrames_.size() );
+  if( i >= commentFrames_.size() )
+    return {};
 
   const auto* rawFrame = GetCommentFrame( i )->GetData();
   const auto* commentFrame = reinterpret_cast<const ID3v2CommentFrame*>( rawFrame );
   assert( IsCommentFrame( commentFrame->GetFrameID() ) );
-  return commentFrame->GetText( fileHeader_.GetMajorVersion() );
+  return commentFrame->GetView( fileHeader_.GetMajorVersion() );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Find comment by description and language; multiple comments may share a
+// description as long as their languages differ
+
+std::optional<ID3v2CommentView> Mp3TagData::FindComment( std::string_view description,
+                                                         std::string_view language ) const
+{
+  auto [ first, last ] = commentIndex_.equal_range( description );
+  for( auto it = first; it != last; ++it )
+  {
+    const auto* commentFrame = reinterpret_cast<const ID3v2CommentFrame*>( frames_[ it->second ].GetData() );
+    auto view = commentFrame->GetView( fileHeader_.GetMajorVersion() );
+    if( language.empty() || view.GetLanguage() == language )
+      return view;
+  }
+  return std::nullopt;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// User-defined text frames
+
+std::string Mp3TagData::GetUserText( std::string_view description ) const
+{
+  auto userText = FindUserText( description );
+  return userText ? userText->GetText() : std::string();
+}
+
+std::optional<ID3v2UserTextView> Mp3TagData::FindUserText( std::string_view description ) const
+{
+  auto it = userTextIndex_.find( description );
+  if( it == std::end( userTextIndex_ ) )
+    return std::nullopt;
+  const auto* userTextFrame = reinterpret_cast<const ID3v2UserTextFrame*>( frames_[ it->second ].GetData() );
+  return userTextFrame->GetView( fileHeader_.GetMajorVersion() );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Update existing TXXX frame, create new frame if one doesn't exist, or
+// delete frame if value is empty
+
+void Mp3TagData::SetUserText( const std::string& description, const std::string& value )
+{
+  auto it = userTextIndex_.find( description );
+  size_t framePos = ( it == std::end( userTextIndex_ ) ) ? kInvalidFramePos : it->second;
+  if( value.empty() )
+  {
+    if( framePos == kInvalidFramePos )
+      return;
+    frames_[ framePos ].FlagToDelete();
+    userTextIndex_.erase( it );
+    isDirty_ = true;
+    return;
+  }
+
+  if( framePos == kInvalidFramePos )
+  {
+    // Description isn't in MP3 file; create new frame
+    frames_.emplace_back( ID3Frame{} );
+    framePos = frames_.size() - 1;
+  }
+  Mp3TagData::ID3Frame* pFrame = &( frames_[ framePos ] );
+
+  // Create a TXXX frame of the proper size
+  auto sizeAlloc = ID3v2UserTextFrame::GetFrameSize( description, value );
+  pFrame->Allocate( sizeAlloc );
+
+  // Set the frame fields
+  uint32_t frameSize = static_cast<uint32_t>( sizeAlloc - sizeof( ID3v2FrameHdr ) );
+  ID3v2UserTextFrame* pUserTextFrame = reinterpret_cast<ID3v2UserTextFrame*>( pFrame->GetData() );
+  pUserTextFrame->SetHeader( "TXXX", frameSize, fileHeader_.GetMajorVersion() );
+  pUserTextFrame->SetText( description, value );
+  userTextIndex_.insert_or_assign( description, framePos );
+  isDirty_ = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Generic frame access
+
+Mp3TagData::FrameIterator::FrameIterator( const Mp3TagData* tagData, size_t framePos )
+  : tagData_( tagData ), framePos_( framePos )
+{
+  SkipDeleted();
+}
+
+void Mp3TagData::FrameIterator::SkipDeleted()
+{
+  while( framePos_ < tagData_->frames_.size() && tagData_->frames_[ framePos_ ].IsDeleted() )
+    ++framePos_;
+}
+
+Mp3FrameRef Mp3TagData::FrameIterator::operator*() const
+{
+  return tagData_->GetFrameRef( framePos_ );
+}
+
+Mp3TagData::FrameIterator& Mp3TagData::FrameIterator::operator++()
+{
+  ++framePos_;
+  SkipDeleted();
+  return *this;
+}
+
+Mp3TagData::FrameIterator Mp3TagData::FrameIterator::operator++( int )
+{
+  FrameIterator prev = *this;
+  ++( *this );
+  return prev;
+}
+
+Mp3TagData::FrameIterator Mp3TagData::FrameRange::begin() const
+{
+  return FrameIterator( tagData_, 0u );
+}
+
+Mp3TagData::FrameIterator Mp3TagData::FrameRange::end() const
+{
+  return FrameIterator( tagData_, tagData_->frames_.size() );
+}
+
+Mp3TagData::FrameRange Mp3TagData::GetFrames() const
+{
+  return FrameRange( this );
+}
+
+std::optional<Mp3FrameRef> Mp3TagData::GetFrame( std::string_view frameID ) const
+{
+  assert( frameID.size() == kFrameIDCharCount );
+  for( size_t i = 0u; i < frames_.size(); ++i )
+  {
+    const ID3Frame& frame = frames_[ i ];
+    if( frame.IsDeleted() )
+      continue;
+    if( memcmp( frame.GetHeader(), frameID.data(), kFrameIDCharCount ) == 0 )
+      return GetFrameRef( i );
+  }
+  return std::nullopt;
+}
+
+Mp3FrameRef Mp3TagData::GetFrameRef( size_t framePos ) const
+{
+  assert( framePos < frames_.size() );
+  const auto* rawFrame = frames_[ framePos ].GetData();
+  const auto* frameHdr = reinterpret_cast<const ID3v2FrameHdr*>( rawFrame );
+  const auto* payload = rawFrame + sizeof( ID3v2FrameHdr );
+  uint32_t size = frameHdr->GetSize( fileHeader_.GetMajorVersion() );
+
+  // Frames read from the file may claim more bytes than the tag holds
+  const auto* bufferStart = id3FrameBuffer_.data();
+  const auto* bufferEnd = bufferStart + id3FrameBuffer_.size();
+  if( rawFrame >= bufferStart && rawFrame < bufferEnd )
+    size = static_cast<uint32_t>( std::min<ptrdiff_t>( size, std::max<ptrdiff_t>( bufferEnd - payload, 0 ) ) );
+
+  return Mp3FrameRef{ frameHdr->GetFrameIDView(), frameHdr->GetFlags(), size,
+                      std::span<const uint8_t>( payload, size ) };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Synchronized text
+
+bool Mp3TagData::LoadSyncedText( std::string_view language )
+{
+  syncedText_ = ID3v2SyncedText{};
+  for( const auto& frame : GetFrames() )
+  {
+    if( frame.id != "SYLT" )
+      continue;
+    if( !language.empty() && ID3v2SyncedText::GetLanguage( frame.payload ) != language )
+      continue;
+
+    // Timestamps may be in MPEG frames rather than milliseconds
+    if( audioInfo_.sampleRate == 0u )
+      LoadAudioInfo();
+    return syncedText_.Parse( frame.payload, audioInfo_.sampleRate, audioInfo_.samplesPerFrame );
+  }
+  return false;
+}
+
+const ID3v2SyncedText& Mp3TagData::GetSyncedText() const
+{
+  return syncedText_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Chapters
+
+bool Mp3TagData::LoadChapters()
+{
+  chapters_.Clear();
+  for( const auto& frame : GetFrames() )
+  {
+    if( frame.id == "CHAP" )
+    {
+      if( !chapters_.AddChapter( frame.payload, fileHeader_.GetMajorVersion() ) )
+        PKLOG_WARN( "\nMalformed CHAP frame in %S\n", path_.c_str() );
+    }
+    else if( frame.id == "CTOC" )
+    {
+      if( !chapters_.AddTableOfContents( frame.payload, fileHeader_.GetMajorVersion() ) )
+        PKLOG_WARN( "\nMalformed CTOC frame in %S\n", path_.c_str() );
+    }
+  }
+  chapters_.SortByTime();
+  return !chapters_.IsEmpty();
+}
+
+const ID3v2Chapters& Mp3TagData::GetChapters() const
+{
+  return chapters_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Typed numeric fields
+
+std::optional<Mp3TrackNumber> Mp3TagData::GetTrack() const
+{
+  const auto& field = numericFields_[ static_cast<size_t>( Mp3FrameType::TrackNum ) ];
+  if( !field.isValid )
+    return std::nullopt;
+  return Mp3TrackNumber{ field.value, field.total };
+}
+
+std::optional<uint32_t> Mp3TagData::GetYear() const
+{
+  return GetNumericField( Mp3FrameType::Year );
+}
+
+std::optional<uint32_t> Mp3TagData::GetOrigYear() const
+{
+  return GetNumericField( Mp3FrameType::OrigYear );
+}
+
+std::optional<uint32_t> Mp3TagData::GetBpm() const
+{
+  return GetNumericField( Mp3FrameType::BeatsPerMinute );
+}
+
+std::optional<uint32_t> Mp3TagData::GetDurationMs() const
+{
+  return GetNumericField( Mp3FrameType::Duration );
+}
+
+std::optional<uint32_t> Mp3TagData::GetNumericField( Mp3FrameType frameType ) const
+{
+  const auto& field = numericFields_[ static_cast<size_t>( frameType ) ];
+  return field.isValid ? std::optional<uint32_t>( field.value ) : std::nullopt;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Parse a numeric text frame into numericFields_. Digits are read straight
+// from the frame bytes; wide frames are narrowed into a small stack buffer.
+
+void Mp3TagData::ParseNumericField( Mp3FrameType frameType )
+{
+  if( std::ranges::find( kNumericFrameTypes, frameType ) == kNumericFrameTypes.end() )
+    return;
+  auto& field = numericFields_[ static_cast<size_t>( frameType ) ];
+  field = NumericField{};
+
+  constexpr size_t kMaxDigitChars = 32;
+  char digits[ kMaxDigitChars ];
+  std::string_view text;
+  std::string id3v1Text;
+  if( const ID3Frame* pFrame = GetTextFrame( frameType ); pFrame != nullptr )
+  {
+    const auto* textFrame = reinterpret_cast<const ID3v2TextFrame*>( pFrame->GetData() );
+    text = textFrame->GetRawText( fileHeader_.GetMajorVersion() );
+    if( textFrame->IsWideString() )
+    {
+      // ASCII code units have one zero byte in either byte order
+      size_t charCount = 0u;
+      for( size_t i = 0u; i + 1 < text.size() && charCount < kMaxDigitChars; i += 2 )
+      {
+        char lo = text[ i ];
+        char hi = text[ i + 1 ];
+        char c = ( hi == '\0' ) ? lo : ( lo == '\0' ) ? hi : '?';
+        if( c == '\0' )
+          break;
+        digits[ charCount++ ] = c;
+      }
+      text = std::string_view( digits, charCount );
+    }
+  }
+  else if( hasID3v1_ && ( frameType == Mp3FrameType::Year || frameType == Mp3FrameType::TrackNum ) )
+  {
+    id3v1Text = GetID3v1Text( frameType );
+    text = id3v1Text;
+  }
+
+  const char* end = text.data() + text.size();
+  const char* p = ParseNumber( text.data(), end, field.value );
+  if( p == nullptr )
+    return;
+  field.isValid = true;
+
+  if( frameType == Mp3FrameType::TrackNum )
+  {
+    while( p < end && *p == ' ' )
+      ++p;
+    if( p < end && *p == '/' && !ParseNumber( p + 1, end, field.total ) )
+      field.total = 0u;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Multi-valued text frame as a range of views into the frame
+
+ID3v2TextValues Mp3TagData::GetTextValues( Mp3FrameType frameType, bool splitOnSlash ) const
+{
+  assert( IsTextFrame( frameType ) );
+  const ID3Frame* pFrame = GetTextFrame( frameType );
+  if( pFrame == nullptr )
+    return {};
+
+  const auto* textFrame = reinterpret_cast<const ID3v2TextFrame*>( pFrame->GetData() );
+  bool isBigEndian = ( textFrame->GetTextEncoding() == ID3TextEncoding::UTF16BE );
+  return ID3v2TextValues( textFrame->GetRawText( fileHeader_.GetMajorVersion() ),
+                          textFrame->IsWideString(), isBigEndian, splitOnSlash );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -175,7 +711,7 @@ void Mp3TagData::SetText( Mp3FrameType frameType, const std::string& newStr )
     // Frame type isn't in MP3 file; create new frame and add to right lists 
     frames_.emplace_back( ID3Frame{} );
     framePos = frames_.size() - 1;
-    textFrames_.emplace_back( framePos );
+    textFrameIndex_[ static_cast<size_t>( frameType ) ] = framePos;
   }
   Mp3TagData::ID3Frame* pFrame = &( frames_[ framePos ] );
 
@@ -189,130 +725,716 @@ void Mp3TagData::SetText( Mp3FrameType frameType, const std::string& newStr )
   ID3v2TextFrame* pTextFrame = reinterpret_cast<ID3v2TextFrame*>( pFrame->GetData() );
   pTextFrame->SetHeader( frameID, frameSize, fileHeader_.GetMajorVersion() );
   pTextFrame->SetText( newStr );
+  ParseNumericField( frameType );
+  textCache_[ static_cast<size_t>( frameType ) ].reset();
+  isDirty_ = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Set the comment at the given position; use position GetCommentCount() 
+// to add a new comment; deletes comment frame if newComment is empty
+
+void Mp3TagData::SetComment( size_t i, const std::string& newComment )
+{
+  if( newComment.empty() )
+  {
+    DeleteCommentFrame( i );
+    return;
+  }
+
+  assert( i <= commentFrames_.size() );
+  if( i == commentFrames_.size() )
+  {
+    // Comment at index i isn't in file yet; create new frame and add to right lists 
+    frames_.emplace_back( ID3Frame{} );
+    commentFrames_.emplace_back( frames_.size() - 1 );
+  }
+
+  FramePos framePos = commentFrames_[ i ];
+  Mp3TagData::ID3Frame* pFrame = &( frames_[framePos] );
+
+  // Create a comment frame of the proper size
+  auto sizeAlloc = ID3v2CommentFrame::GetFrameSize( newComment );
+  pFrame->Allocate( sizeAlloc );
+
+  // Set the frame fields
+  uint32_t frameSize = static_cast<uint32_t>( sizeAlloc - sizeof( ID3v2FrameHdr ) );
+  std::string frameID = GetFrameID( Mp3FrameType::Comment );
+  ID3v2CommentFrame* pCommentFrame = reinterpret_cast<ID3v2CommentFrame*>( pFrame->GetData() );
+  pCommentFrame->SetHeader( frameID, frameSize, fileHeader_.GetMajorVersion() );
+  pCommentFrame->SetText( newComment );
+  IndexComments();
   isDirty_ = true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// Set the comment at the given position; use position GetCommentCount() 
-// to add a new comment; deletes comment frame if newComment is empty
+// Location in file where to start looking for MPEG audio data
+
+uint32_t Mp3TagData::GetAudioBufferOffset() const
+{
+  return audioBufferOffset_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// APE item lookup by case-insensitive key
+
+bool Mp3TagData::HasAPEItem( std::string_view key ) const
+{
+  return GetAPETag( key ) != nullptr;
+}
+
+std::string Mp3TagData::GetAPEText( std::string_view key ) const
+{
+  const APETag* pTag = GetAPETag( key );
+  if( pTag == nullptr )
+    return std::string();
+
+  const auto* apeTagItem = reinterpret_cast<const APEv2TagItem*>( pTag->GetData() );
+  if( !apeTagItem->IsText() )
+    return std::string();
+  return apeTagItem->GetText();
+}
+
+std::span<const uint8_t> Mp3TagData::GetAPEData( std::string_view key ) const
+{
+  const APETag* pTag = GetAPETag( key );
+  if( pTag == nullptr )
+    return {};
+
+  const auto* apeTagItem = reinterpret_cast<const APEv2TagItem*>( pTag->GetData() );
+  return apeTagItem->GetData();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Update existing APE item, create new item if one doesn't exist, or
+// delete item if the value is empty
+
+void Mp3TagData::SetAPEText( std::string_view key, const std::string& newText )
+{
+  auto value = std::span{ reinterpret_cast<const uint8_t*>( newText.data() ), newText.size() };
+  SetAPEItem( key, value, false );
+}
+
+void Mp3TagData::SetAPEData( std::string_view key, std::span<const uint8_t> newData )
+{
+  SetAPEItem( key, newData, true );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// ID3v1 tag access; ID3v1 has a small fixed set of fields
+
+bool Mp3TagData::HasID3v1Tag() const
+{
+  return hasID3v1_;
+}
+
+std::string Mp3TagData::GetID3v1Text( Mp3FrameType frameType ) const
+{
+  if( !hasID3v1_ )
+    return std::string();
+
+  switch( frameType )
+  {
+  case Mp3FrameType::Title:  return id3v1Tag_.GetTitle();
+  case Mp3FrameType::Artist: return id3v1Tag_.GetArtist();
+  case Mp3FrameType::Album:  return id3v1Tag_.GetAlbum();
+  case Mp3FrameType::Year:   return id3v1Tag_.GetYear();
+  case Mp3FrameType::TrackNum:
+    return id3v1Tag_.HasTrack() ? std::to_string( id3v1Tag_.GetTrack() ) : std::string();
+  case Mp3FrameType::Genre:
+    return ( id3v1Tag_.GetGenre() <= kMaxGenre ) ? GetGenre( id3v1Tag_.GetGenre() ) : std::string();
+  default:
+    return std::string();
+  }
+}
+
+std::string Mp3TagData::GetID3v1Comment() const
+{
+  return hasID3v1_ ? id3v1Tag_.GetComment() : std::string();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Update an ID3v1 field, creating the ID3v1 tag if there isn't one. Values
+// that don't fit are truncated. Genres not in kStaticGenreList are cleared.
+
+void Mp3TagData::SetID3v1Text( Mp3FrameType frameType, const std::string& newStr )
+{
+  if( !hasID3v1_ )
+  {
+    id3v1Tag_.Clear();
+    hasID3v1_ = true;
+  }
+
+  switch( frameType )
+  {
+  case Mp3FrameType::Title:  id3v1Tag_.SetTitle( newStr );  break;
+  case Mp3FrameType::Artist: id3v1Tag_.SetArtist( newStr ); break;
+  case Mp3FrameType::Album:  id3v1Tag_.SetAlbum( newStr );  break;
+  case Mp3FrameType::Year:   id3v1Tag_.SetYear( newStr );   break;
+  case Mp3FrameType::TrackNum:
+  {
+    // e.g. "5/12" -> 5
+    uint32_t track = 0u;
+    std::from_chars( newStr.data(), newStr.data() + newStr.size(), track );
+    id3v1Tag_.SetTrack( static_cast<uint8_t>( std::min( track, uint32_t( UINT8_MAX ) ) ) );
+    break;
+  }
+  case Mp3FrameType::Genre:
+  {
+    // Accepts TCON-style references, e.g. "(17)"
+    auto genre = FindGenre( ResolveGenre( newStr ) );
+    id3v1Tag_.SetGenre( genre.value_or( ID3v1Tag::kNoGenre ) );
+    break;
+  }
+  default:
+    assert( false ); // no such field in ID3v1
+    return;
+  }
+  if( GetTextFrame( frameType ) == nullptr )
+  {
+    // ID3v1 is the fallback
+    ParseNumericField( frameType );
+    textCache_[ static_cast<size_t>( frameType ) ].reset();
+  }
+  isTailDirty_ = true;
+}
+
+void Mp3TagData::SetID3v1Comment( const std::string& newComment )
+{
+  if( !hasID3v1_ )
+  {
+    id3v1Tag_.Clear();
+    hasID3v1_ = true;
+  }
+  id3v1Tag_.SetComment( newComment );
+  isTailDirty_ = true;
+}
+
+void Mp3TagData::RemoveID3v1Tag()
+{
+  if( !hasID3v1_ )
+    return;
+  hasID3v1_ = false;
+  ParseNumericField( Mp3FrameType::Year );
+  ParseNumericField( Mp3FrameType::TrackNum );
+  ClearTextCache();
+  isTailDirty_ = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Choose the order in which tag sources are consulted by ResolveText().
+// Sources left out of the order are never consulted.
+
+void Mp3TagData::SetSourcePrecedence( const SourceOrder& sourceOrder )
+{
+  sourceOrder_ = sourceOrder;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Answer a field from the first source in precedence order that has a value.
+// Every source is indexed when the tags are loaded, so each probe is O(1).
+
+std::string Mp3TagData::ResolveText( Mp3FrameType frameType ) const
+{
+  assert( frameType > Mp3FrameType::None && frameType < Mp3FrameType::Max );
+  for( auto source : sourceOrder_ )
+  {
+    std::string value = GetSourceText( source, frameType );
+    if( !value.empty() )
+      return value;
+  }
+  return std::string();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Answer a field that has no Mp3FrameType, e.g. "REPLAYGAIN_TRACK_GAIN",
+// from TXXX frames or APE items. ID3v1 has no such fields.
+
+std::string Mp3TagData::ResolveUserText( std::string_view key ) const
+{
+  for( auto source : sourceOrder_ )
+  {
+    std::string value;
+    if( source == Mp3TagSource::ID3v2 )
+      value = GetUserText( key );
+    else if( source == Mp3TagSource::APE )
+      value = GetAPEText( key );
+    if( !value.empty() )
+      return value;
+  }
+  return std::string();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Field from a single tag source; empty if not present
+
+std::string Mp3TagData::GetSourceText( Mp3TagSource source, Mp3FrameType frameType ) const
+{
+  switch( source )
+  {
+  case Mp3TagSource::ID3v2:
+    if( frameType == Mp3FrameType::Comment )
+      return commentFrames_.empty() ? std::string() : GetComment( 0 );
+    if( GetTextFrameReferencePos( frameType ) == kInvalidFramePos )
+      return std::string(); // no ID3v1 fallback here, unlike GetText()
+    return GetText( frameType );
+  case Mp3TagSource::APE:
+  {
+    TagPos tagPos = apeFieldIndex_[ static_cast<size_t>( frameType ) ];
+    if( tagPos == kInvalidFramePos )
+      return std::string();
+    const auto* apeTagItem = reinterpret_cast<const APEv2TagItem*>( apeTags_[ tagPos ].GetData() );
+    return apeTagItem->IsText() ? apeTagItem->GetText() : std::string();
+  }
+  case Mp3TagSource::ID3v1:
+    return ( frameType == Mp3FrameType::Comment ) ? GetID3v1Comment() : GetID3v1Text( frameType );
+  default:
+    return std::string();
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Location in file where tail tags (APE, ID3v1) begin; end of MPEG audio data
+
+uint64_t Mp3TagData::GetAudioEndOffset() const
+{
+  return audioEndOffset_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copy whole frames from another tag without decoding them. Only the size
+// field needs re-encoding if the major versions differ. Frames with format
+// flags (compression, encryption, grouping) are skipped in that case, since
+// those flags and their extra header bytes differ between versions.
+
+size_t Mp3TagData::CopyFramesFrom( const Mp3TagData& source, std::span<const std::string_view> frameIDs )
+{
+  if( &source == this )
+    return 0u;
+
+  uint8_t sourceVersion = source.fileHeader_.GetMajorVersion();
+  uint8_t majorVersion = fileHeader_.GetMajorVersion();
+  bool isSameVersion = ( sourceVersion == majorVersion );
+
+  // Select source frames
+  std::vector<FramePos> copyFrames;
+  std::vector<std::string> copyIDs;
+  for( size_t i = 0u; i < source.frames_.size(); ++i )
+  {
+    const ID3Frame& frame = source.frames_[ i ];
+    if( frame.IsDeleted() )
+      continue;
+    std::string frameID = frame.GetFrameID();
+    if( !frameIDs.empty() && std::ranges::find( frameIDs, frameID ) == frameIDs.end() )
+      continue;
+    // Unsynchronized, grouped and length-prefixed frames are read decoded, with
+    // their format flags cleared. Compressed and encrypted frames keep their
+    // prefixes, whose layout differs by version, so they can't be converted
+    const auto* frameHdr = reinterpret_cast<const ID3v2FrameHdr*>( frame.GetData() );
+    if( !isSameVersion && ( source.IsOpaqueFrame( frame ) || frameHdr->HasFormatFlags() ) )
+    {
+      PKLOG_WARN( "\nCan't convert compressed or encrypted frame %s to ID3v2.%d; skipped\n",
+                  frameID.c_str(), majorVersion );
+      continue;
+    }
+    copyFrames.push_back( i );
+    if( std::ranges::find( copyIDs, frameID ) == copyIDs.end() )
+      copyIDs.push_back( std::move( frameID ) );
+  }
+  if( copyFrames.empty() )
+    return 0u;
+
+  // Copied frames replace existing frames with the same ID
+  for( auto& frame : frames_ )
+  {
+    if( !frame.IsDeleted() && std::ranges::find( copyIDs, frame.GetFrameID() ) != copyIDs.end() )
+      frame.FlagToDelete();
+  }
+
+  for( FramePos i : copyFrames )
+  {
+    const ID3Frame& sourceFrame = source.frames_[ i ];
+    uint32_t frameBytes = sourceFrame.GetWriteBytes( sourceVersion );
+    frames_.emplace_back( ID3Frame{} );
+    ID3Frame& frame = frames_.back();
+    frame.Allocate( frameBytes );
+    memcpy( frame.GetData(), sourceFrame.GetData(), frameBytes );
+    if( !isSameVersion )
+    {
+      auto* frameHdr = reinterpret_cast<ID3v2FrameHdr*>( frame.GetData() );
+      frameHdr->SetSize( frameHdr->GetSize( sourceVersion ), majorVersion );
+      frameHdr->ConvertFlags( sourceVersion, majorVersion );
+    }
+  }
+
+  IndexID3Frames();
+  isDirty_ = true;
+  return copyFrames.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copy frames of the given types; see above
+
+size_t Mp3TagData::CopyFramesFrom( const Mp3TagData& source, std::span<const Mp3FrameType> frameTypes )
+{
+  std::vector<std::string_view> frameIDs;
+  frameIDs.reserve( frameTypes.size() );
+  for( auto frameType : frameTypes )
+    frameIDs.push_back( kMp3FrameID.at( frameType ) );
+  if( frameIDs.empty() )
+    return 0u; // an empty list of types copies nothing rather than everything
+  return CopyFramesFrom( source, frameIDs );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Choose the ID3v2 frame order for the next write. Doesn't make the tag dirty.
+
+void Mp3TagData::SetFrameOrder( Mp3FrameOrder frameOrder )
+{
+  frameOrder_ = frameOrder;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Write modified or deleted frames and tags to the file, making sure that
+// audio data remains intact
+
+bool Mp3TagData::Write()
+{
+  if( !IsDirty() )
+    return false;
+
+  // APE and ID3v1 tags live at the end of the file, so they're updated first. If
+  // the ID3v2 section then grows, the new tail moves along with the audio data.
+  if( isTailDirty_ && !WriteTail() )
+    return false;
+  if( isDirty_ && !WriteID3Frames() )
+    return false;
+
+  // Update all fields with correct new data
+  return LoadTagData( path_ );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Write modified or deleted ID3 frames, making sure that audio and APE data
+// remains intact
+
+bool Mp3TagData::WriteID3Frames()
+{
+  // Padding bytes depends on whether new frames will fit within existing space.
+  // Files without an ID3v2 section have zero existing space.
+  size_t frameSectionSize = GetID3FrameSectionSize();
+  size_t existingSectionSize = fileHeader_.GetSize();
+  size_t padBytes = ( frameSectionSize > existingSectionSize ) ? 
+                      kPaddingBytes : ( existingSectionSize - frameSectionSize );
+
+  fileHeader_.SetSize( static_cast<uint32_t>( frameSectionSize + padBytes ) );
+  std::vector<uint8_t> id3Tag;
+  SerializeID3Tag( padBytes, id3Tag );
+  return WriteID3Section( path_, audioBufferOffset_, id3Tag );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Replace the ID3v2 section of the file at path, which currently ends at
+// audioOffset. If the new section is a different size, everything after it
+// is moved.
+
+bool Mp3TagData::WriteID3Section( const std::filesystem::path& path, uint64_t audioOffset,
+                                  const std::vector<uint8_t>& id3Tag ) // static
+{
+  File mp3File( path );
+  if( !mp3File.Open( FileFlags::Read | FileFlags::Write | FileFlags::SharedRead | FileFlags::SharedWrite ) )
+  {
+    PKLOG_WARN( "Failed to write MP3 data to %S; ERR: %d\n", path.c_str(), Util::GetLastError() );
+
+    // Try one more time; useful in debugging scenarios
+    if( !mp3File.Open( FileFlags::Read | FileFlags::Write | FileFlags::SharedRead | FileFlags::SharedWrite ) )
+      return false;
+  }
+  uint64_t fileSize = mp3File.GetLength();
+
+  // Read existing audio and APE data if we're going to overwrite it
+  std::vector<uint8_t> audioData;
+  bool isMoving = ( id3Tag.size() != audioOffset );
+  if( isMoving )
+  {
+    uint64_t audioDataSize64 = fileSize - audioOffset;
+    assert( audioDataSize64 <= std::numeric_limits<uint32_t>::max() );
+    uint32_t audioDataSize = static_cast<uint32_t>( audioDataSize64 );
+    audioData.resize( audioDataSize );
+    if( !mp3File.SetPos( audioOffset ) || !mp3File.Read( audioData.data(), audioDataSize ) )
+      return false;
+  }
+
+  // Write new ID3v2 header, all frames except deleted ones, and padding
+  if( !mp3File.SetPos( 0 ) )
+    return false;
+  if( !id3Tag.empty() && !mp3File.Write( id3Tag.data(), uint32_t( id3Tag.size() ) ) )
+    return false;
+
+  // Append audio and APE data if it was overwritten
+  if( !audioData.empty() )
+    verify( mp3File.Write( audioData.data(), uint32_t( audioData.size() ) ) );
+  mp3File.Close();
+
+  // Chop off any leftovers if the section shrank
+  uint64_t newFileSize = id3Tag.size() + audioData.size();
+  if( isMoving && newFileSize < fileSize )
+  {
+    std::error_code errorCode;
+    std::filesystem::resize_file( path, newFileSize, errorCode );
+    if( errorCode )
+    {
+      PKLOG_WARN( "Failed to truncate %S; ERR: %d\n", path.c_str(), errorCode.value() );
+      return false;
+    }
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Bytes required for all frames except deleted ones
+
+size_t Mp3TagData::GetID3FrameSectionSize() const
+{
+  // same as std::accumulate
+  return std::ranges::fold_left( frames_, size_t{}, [ fh = fileHeader_ ]( size_t sum, const ID3Frame& frame )
+    {
+      return sum + frame.GetWriteBytes( fh.GetMajorVersion() );
+    } );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Build a complete ID3v2 tag in memory: file header, all frames except deleted
+// ones, then padBytes of zeros. Unsaved edits are included.
 
-void Mp3TagData::SetComment( size_t i, const std::string& newComment )
+void Mp3TagData::SerializeID3Tag( size_t padBytes, std::vector<uint8_t>& id3Tag ) const
 {
-  if( newComment.empty() )
+  size_t frameSectionSize = GetID3FrameSectionSize();
+  ID3v2FileHeader fileHeader( fileHeader_ );
+  fileHeader.SetSize( static_cast<uint32_t>( frameSectionSize + padBytes ) );
+
+  // Determine write order
+  std::vector<FramePos> writeOrder( frames_.size() );
+  std::iota( writeOrder.begin(), writeOrder.end(), FramePos{} );
+  if( frameOrder_ == Mp3FrameOrder::CommonFirst )
   {
-    DeleteCommentFrame( i );
-    return;
+    std::vector<size_t> ranks;
+    ranks.reserve( frames_.size() );
+    for( const auto& frame : frames_ )
+      ranks.push_back( GetFrameWriteRank( frame.GetFrameID() ) );
+    std::ranges::stable_sort( writeOrder, {}, [ &ranks ]( FramePos i ) { return ranks[ i ]; } );
   }
 
-  assert( i <= commentFrames_.size() );
-  if( i == commentFrames_.size() )
+  id3Tag.assign( sizeof( fileHeader ) + frameSectionSize + padBytes, 0 ); // zeros are padding
+  memcpy( id3Tag.data(), &fileHeader, sizeof( fileHeader ) );
+  size_t offset = sizeof( fileHeader );
+  for( FramePos i : writeOrder )
   {
-    // Comment at index i isn't in file yet; create new frame and add to right lists 
-    frames_.emplace_back( ID3Frame{} );
-    commentFrames_.emplace_back( frames_.size() - 1 );
+    const auto& frame = frames_[ i ];
+    if( auto frameBytes = frame.GetWriteBytes( fileHeader_.GetMajorVersion() ); frameBytes )
+    {
+      memcpy( id3Tag.data() + offset, frame.GetData(), frameBytes );
+      offset += frameBytes;
+    }
   }
+  assert( offset == sizeof( fileHeader ) + frameSectionSize );
+}
 
-  FramePos framePos = commentFrames_[ i ];
-  Mp3TagData::ID3Frame* pFrame = &( frames_[framePos] );
+///////////////////////////////////////////////////////////////////////////////
+//
+// Rewrite the file tail -- APE block (header, items, footer) followed by the
+// ID3v1 tag -- in place. Only the tail of the file is touched; audio and ID3v2
+// data never move.
 
-  // Create a comment frame of the proper size
-  auto sizeAlloc = ID3v2CommentFrame::GetFrameSize( newComment );
-  pFrame->Allocate( sizeAlloc );
+bool Mp3TagData::WriteTail()
+{
+  // With no existing APE block, the tail starts where the ID3v1 tag was (or EOF)
+  uint64_t tailStart = ( apeStart_ != kNoApeHeader ) ? apeStart_ : audioEndOffset_;
 
-  // Set the frame fields
-  uint32_t frameSize = static_cast<uint32_t>( sizeAlloc - sizeof( ID3v2FrameHdr ) );
-  std::string frameID = GetFrameID( Mp3FrameType::Comment );
-  ID3v2CommentFrame* pCommentFrame = reinterpret_cast<ID3v2CommentFrame*>( pFrame->GetData() );
-  pCommentFrame->SetHeader( frameID, frameSize, fileHeader_.GetMajorVersion() );
-  pCommentFrame->SetText( newComment );
-  isDirty_ = true;
+  std::vector<uint8_t> tail;
+  SerializeTail( tail );
+  return WriteTailAt( path_, tailStart, tail );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// Location in file where to start looking for MPEG audio data
+// Build the APE block and ID3v1 tag in memory so the tail is a single write
 
-uint32_t Mp3TagData::GetAudioBufferOffset() const
+void Mp3TagData::SerializeTail( std::vector<uint8_t>& tail ) const
 {
-  return audioBufferOffset_;
+  size_t itemBytes = 0u;
+  uint32_t itemCount = 0u;
+  for( const auto& tag : apeTags_ )
+  {
+    if( auto tagBytes = tag.GetWriteBytes(); tagBytes )
+    {
+      itemBytes += tagBytes;
+      ++itemCount;
+    }
+  }
+
+  tail.clear();
+  if( itemCount )
+  {
+    // Per the spec, the tag size includes the items and footer but not the header
+    uint32_t tagSize = static_cast<uint32_t>( itemBytes + sizeof( APEv2TagHeader ) );
+    tail.resize( sizeof( APEv2TagHeader ) + tagSize );
+    auto* header = reinterpret_cast<APEv2TagHeader*>( tail.data() );
+    header->SetHeader( tagSize, itemCount, true );
+
+    size_t offset = sizeof( APEv2TagHeader );
+    for( const auto& tag : apeTags_ )
+    {
+      if( auto tagBytes = tag.GetWriteBytes(); tagBytes )
+      {
+        memcpy( tail.data() + offset, tag.GetData(), tagBytes );
+        offset += tagBytes;
+      }
+    }
+
+    auto* footer = reinterpret_cast<APEv2TagHeader*>( tail.data() + offset );
+    footer->SetHeader( tagSize, itemCount, false );
+  }
+  if( hasID3v1_ )
+  {
+    const auto* rawID3v1 = reinterpret_cast<const uint8_t*>( &id3v1Tag_ );
+    tail.insert( tail.end(), rawID3v1, rawID3v1 + ID3v1Tag::kTagSize );
+  }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// Write modified or deleted frames to the given file, making sure that audio
-// and APE data remains intact
+// Overwrite the file at path from tailStart to EOF with the given tail
 
-bool Mp3TagData::Write()
+bool Mp3TagData::WriteTailAt( const std::filesystem::path& path, uint64_t tailStart,
+                              const std::vector<uint8_t>& tail ) // static
 {
-  if( !IsDirty() )
+  File mp3File( path );
+  if( !mp3File.Open( FileFlags::Read | FileFlags::Write | FileFlags::SharedRead | FileFlags::SharedWrite ) )
+  {
+    PKLOG_WARN( "Failed to write tail tags to %S; ERR: %d\n", path.c_str(), Util::GetLastError() );
     return false;
+  }
+  uint64_t fileSize = mp3File.GetLength();
 
-  // same as std::accumulate
-  size_t frameSectionSize = 
-    std::ranges::fold_left( frames_, size_t{}, [ fh = fileHeader_ ]( size_t sum, const ID3Frame& frame )
+  if( !tail.empty() )
+  {
+    if( !mp3File.SetPos( tailStart ) || 
+        !mp3File.Write( tail.data(), static_cast<uint32_t>( tail.size() ) ) )
     {
-      return sum + frame.GetWriteBytes( fh.GetMajorVersion() );
-    } );
+      PKLOG_WARN( "Failed to write tail tags to %S; ERR: %d\n", path.c_str(), Util::GetLastError() );
+      return false;
+    }
+  }
+  mp3File.Close();
 
-  File mp3File( path_ );
-  if( !mp3File.Open( FileFlags::Read | FileFlags::Write | FileFlags::SharedRead | FileFlags::SharedWrite ) )
+  // Chop off any leftovers if the tail shrank
+  uint64_t newFileSize = tailStart + tail.size();
+  if( newFileSize < fileSize )
   {
-    PKLOG_WARN( "Failed to write MP3 data to %S; ERR: %d\n", path_.c_str(), Util::GetLastError() );
-
-    // Try one more time; useful in debugging scenarios
-    if( !mp3File.Open( FileFlags::Read | FileFlags::Write | FileFlags::SharedRead | FileFlags::SharedWrite ) )
+    std::error_code errorCode;
+    std::filesystem::resize_file( path, newFileSize, errorCode );
+    if( errorCode )
+    {
+      PKLOG_WARN( "Failed to truncate %S; ERR: %d\n", path.c_str(), errorCode.value() );
       return false;
+    }
   }
+  return true;
+}
 
-  // Padding bytes depends on whether new frames will fit within existing space
-  size_t padBytes = ( frameSectionSize > id3FrameBuffer_.size() ) ? 
-                      kPaddingBytes : ( id3FrameBuffer_.size() - frameSectionSize );
-
-  // Write new ID3v2 header size
-  fileHeader_.SetSize( static_cast<uint32_t>( frameSectionSize + padBytes ) );
-  if( !mp3File.Write( &fileHeader_, sizeof( fileHeader_ ) ) )
-    return false;
+///////////////////////////////////////////////////////////////////////////////
+//
+// Make the tags of the replica at replicaPath match this object's tags,
+// including unsaved edits, without touching the replica's audio
+//
+// Only the ID3v2 section and the tail are read and compared. A changed ID3v2
+// section is written in place when it fits the replica's existing section;
+// otherwise the replica's audio has to move, as in Write().
 
-  // Read existing audio and APE data if we're going to overwrite it
-  std::vector<uint8_t> audioData;
-  if( frameSectionSize > id3FrameBuffer_.size() )
+Mp3SyncResult Mp3TagData::SyncTagsTo( const std::filesystem::path& replicaPath, bool verifyAudioHash ) const
+{
+  // The replica may have no tags yet
+  Mp3TagData replica;
+  if( !replica.LocateAudio( replicaPath ) )
+    return Mp3SyncResult::Failed;
+
+  uint64_t audioBytes = audioEndOffset_ - audioBufferOffset_;
+  if( replica.audioEndOffset_ - replica.audioBufferOffset_ != audioBytes )
+    return Mp3SyncResult::AudioDiffers;
+  if( verifyAudioHash )
   {
-    uint64_t audioDataSize64 = mp3File.GetLength() - id3FrameBuffer_.size() - sizeof( fileHeader_ );
-    assert( audioDataSize64 <= std::numeric_limits<uint32_t>::max() );
-    uint32_t audioDataSize = static_cast<uint32_t>( audioDataSize64 );
-    audioData.resize( audioDataSize );
-    uint64_t pos = sizeof( fileHeader_ ) + id3FrameBuffer_.size();
-    if( mp3File.SetPos( pos ) )
-    {
-      mp3File.Read( audioData.data(), audioDataSize );
-      mp3File.SetPos( sizeof( fileHeader_ ) );
-    }
+    uint64_t hash = 0u;
+    uint64_t replicaHash = 0u;
+    if( !GetAudioHash( hash ) || !replica.GetAudioHash( replicaHash ) )
+      return Mp3SyncResult::Failed;
+    if( hash != replicaHash )
+      return Mp3SyncResult::AudioDiffers;
   }
 
-  // Write all frames except deleted ones
-  for( const auto& frame : frames_ )
+  // Fill the replica's existing ID3v2 space when the frames fit so its audio stays put
+  std::vector<uint8_t> id3Tag;
+  if( size_t frameSectionSize = GetID3FrameSectionSize(); frameSectionSize )
   {
-    if( frame.GetWriteBytes( fileHeader_.GetMajorVersion() ) )
-      verify( mp3File.Write( frame.GetData(), frame.GetWriteBytes( fileHeader_.GetMajorVersion() ) ) );
+    size_t replicaSectionSize = ( replica.audioBufferOffset_ > sizeof( ID3v2FileHeader ) ) ?
+                                  replica.audioBufferOffset_ - sizeof( ID3v2FileHeader ) : 0u;
+    size_t padBytes = ( frameSectionSize > replicaSectionSize ) ?
+                        kPaddingBytes : ( replicaSectionSize - frameSectionSize );
+    SerializeID3Tag( padBytes, id3Tag );
   }
+  std::vector<uint8_t> tail;
+  SerializeTail( tail );
 
-  // Pad with zeros
-  if( padBytes )
+  // Read the replica's current tag regions
+  uint64_t replicaTailStart = ( replica.apeStart_ != kNoApeHeader ) ? replica.apeStart_ : replica.audioEndOffset_;
+  std::vector<uint8_t> replicaID3Tag( replica.audioBufferOffset_ );
+  std::vector<uint8_t> replicaTail;
   {
-    // It's possible to have 2K stack buffer rather than a heap allocation, but this is simpler
-    // and dominated by the file write time anyway
-    std::vector<uint8_t> zeros( padBytes, 0 );
-    verify( mp3File.Write( zeros.data(), uint32_t( zeros.size() ) ) );
+    File replicaFile( replicaPath );
+    if( !replicaFile.Open( FileFlags::Read | FileFlags::SharedRead ) )
+      return Mp3SyncResult::Failed;
+    replicaTail.resize( static_cast<size_t>( replicaFile.GetLength() - replicaTailStart ) );
+    if( !replicaFile.Read( replicaID3Tag.data(), static_cast<uint32_t>( replicaID3Tag.size() ) ) ||
+        !replicaFile.SetPos( replicaTailStart ) ||
+        !replicaFile.Read( replicaTail.data(), static_cast<uint32_t>( replicaTail.size() ) ) )
+    {
+      PKLOG_WARN( "Failed to read tags from %S; ERR: %d\n", replicaPath.c_str(), Util::GetLastError() );
+      return Mp3SyncResult::Failed;
+    }
   }
 
-  // Append audio and APE data if it was overwritten
-  if( !audioData.empty() )
-    verify( mp3File.Write( audioData.data(), uint32_t( audioData.size() ) ) );
+  bool isID3Changed = ( id3Tag != replicaID3Tag );
+  bool isTailChanged = ( tail != replicaTail );
+  if( !isID3Changed && !isTailChanged )
+    return Mp3SyncResult::Unchanged;
 
-  // Update all fields with correct new data
-  mp3File.Close();
-  return LoadTagData( path_ );
+  if( isID3Changed && !WriteID3Section( replicaPath, replica.audioBufferOffset_, id3Tag ) )
+    return Mp3SyncResult::Failed;
+
+  // The tail moves with the audio if the ID3v2 section changed size
+  replicaTailStart = replicaTailStart - replica.audioBufferOffset_ + id3Tag.size();
+  if( isTailChanged && !WriteTailAt( replicaPath, replicaTailStart, tail ) )
+    return Mp3SyncResult::Failed;
+  return Mp3SyncResult::TagsSynced;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -335,11 +1457,10 @@ bool Mp3TagData::IsValidFileHeader() const
     return false;
   }
 
-  // Validate flags
+  // Validate flags; unsynchronization and the extended header are handled
+  // by ParseID3Frames()
   auto flags = fileHeader_.GetFlags();
-  if( ( flags & ID3v2FileHeader::kFlagExtended ) ||
-      ( flags & ID3v2FileHeader::kFlagExperimental ) ||
-      ( flags & ID3v2FileHeader::kFlagsRemaining ) )
+  if( flags & ID3v2FileHeader::kFlagsRemaining )
   {
     PKLOG_WARN( "\nSong %S has invalid header flags; resave\n", path_.c_str() );
     return false;
@@ -352,57 +1473,280 @@ bool Mp3TagData::IsValidFileHeader() const
 //
 // True if ID3 frame found and processed; false when there are no more frames left
 
-bool Mp3TagData::ParseID3Frame( uint32_t& offset )
+template <uint8_t kMajorVersion>
+bool Mp3TagData::ParseID3Frame( uint32_t& offset, uint32_t paddingStart, bool isTagUnsynced )
 {
-  // If we've reached end of the tag section, we're done
-  if( offset >= id3FrameBuffer_.size() )
+  // If we've reached padding or the end of the tag section, we're done
+  if( offset >= paddingStart || offset + sizeof( ID3v2FrameHdr ) > id3FrameBuffer_.size() )
     return false;
 
   const auto* rawFrame = id3FrameBuffer_.data() + offset;
 
-  // If we've hit a null byte or header is whacked, 
-  // we're into padding territory and there are no more tags
+  // If the header is whacked, there are no more tags
   if( !Mp3BaseTagData::IsValidFrame( rawFrame ) )
     return false;
 
+  // Frames that need decoding are decoded on first access. Compressed frames
+  // are inflated now if there's an inflate function, so failures are known up
+  // front. Encrypted frames, and compressed frames that can't be inflated, are
+  // kept as-is; they're preserved by Write() and visible through GetFrames(),
+  // but not indexed
+  const auto* frameHdr = reinterpret_cast<const ID3v2FrameHdr*>( rawFrame );
+  uint32_t frameBytes = sizeof( ID3v2FrameHdr ) + frameHdr->GetSize<kMajorVersion>();
+  bool isOpaque = frameHdr->IsOpaque<kMajorVersion>();
+  bool isInflatable = isOpaque && !frameHdr->IsEncrypted( kMajorVersion ) && inflateFunction_ != nullptr;
+  bool isEncoded = ( isTagUnsynced || frameHdr->HasFormatFlags() ) && ( !isOpaque || isInflatable ) &&
+                   ( offset + frameBytes <= id3FrameBuffer_.size() );
+
   // TODO frames_ -> ID3frames_
-  ID3Frame frame( rawFrame );
+  ID3Frame frame( rawFrame, isEncoded ? kMajorVersion : uint8_t( 0u ), isTagUnsynced );
   frames_.emplace_back( frame );
+  if( isOpaque && ( !isEncoded || !frames_.back().Decode() ) )
+  {
+    PKLOG_WARN( "\nFrame %s in %S is %s; not indexed\n", frameHdr->GetFrameID().c_str(), path_.c_str(),
+                frameHdr->IsEncrypted( kMajorVersion ) ? "encrypted" : "compressed" );
+  }
+
+  offset += static_cast<uint32_t>( frameBytes );
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Size of the extended header that precedes the frames; zero if malformed.
+// v2.3 sizes exclude the size field and are plain ints; v2.4 sizes include it
+// and are syncSafe
+
+uint32_t Mp3TagData::GetExtendedHeaderBytes() const
+{
+  uint32_t sizeField = 0u;
+  if( id3FrameBuffer_.size() < sizeof( sizeField ) )
+    return 0u;
+  memcpy( &sizeField, id3FrameBuffer_.data(), sizeof( sizeField ) );
+  uint32_t extHeaderBytes = ( fileHeader_.GetMajorVersion() == kMajorVersionWith8BitSize ) ?
+    ReadID3Int<8>( sizeField ) + uint32_t( sizeof( sizeField ) ) : ReadID3Int<7>( sizeField );
+  if( extHeaderBytes > id3FrameBuffer_.size() )
+  {
+    PKLOG_WARN( "\nInvalid extended header in %S\n", path_.c_str() );
+    return 0u;
+  }
+  return extHeaderBytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Build a plain copy of an unsynchronized, compressed, grouped or length-
+// prefixed frame: the header with format flags cleared and the size adjusted,
+// then the frame data with prefixes and unsynchronization removed, inflated
+// if it was compressed
+
+const uint8_t* Mp3TagData::ID3Frame::GetDecodedFrame() const
+{
+  if( decodedFrame.empty() )
+    verify( BuildDecodedFrame() ); // compressed frames were decoded by ParseID3Frame()
+  return decodedFrame.data();
+}
+
+bool Mp3TagData::ID3Frame::BuildDecodedFrame() const
+{
+  // Prefixes follow the header in flag order. v2.3: decompressed size, then
+  // group ID. v2.4: group ID, then data length, which is the decompressed size
+  const auto* frameHdr = reinterpret_cast<const ID3v2FrameHdr*>( rawFrame );
+  size_t frameSize = frameHdr->GetSize( encodedVersion );
+  bool isCompressed = frameHdr->IsCompressed( encodedVersion );
+  bool isV3 = ( encodedVersion == kMajorVersionWith8BitSize );
+  size_t prefixBytes = 0u;
+  size_t inflatedBytesPos = 0u;
+  if( isCompressed && isV3 )
+  {
+    inflatedBytesPos = prefixBytes;
+    prefixBytes += sizeof( uint32_t );
+  }
+  if( frameHdr->IsGrouped( encodedVersion ) )
+    prefixBytes += sizeof( uint8_t );
+  if( frameHdr->HasDataLengthIndicator( encodedVersion ) )
+  {
+    inflatedBytesPos = prefixBytes;
+    prefixBytes += sizeof( uint32_t );
+  }
+  prefixBytes = std::min( prefixBytes, frameSize );
+
+  const uint8_t* frameData = rawFrame + sizeof( ID3v2FrameHdr ) + prefixBytes;
+  decodedFrame.assign( rawFrame, rawFrame + sizeof( ID3v2FrameHdr ) );
+  decodedFrame.insert( decodedFrame.end(), frameData, frameData + ( frameSize - prefixBytes ) );
+
+  size_t dataBytes = frameSize - prefixBytes;
+  if( isTagUnsynchronized || frameHdr->IsUnsynchronized( encodedVersion ) )
+    dataBytes = RemoveUnsynchronization( decodedFrame.data() + sizeof( ID3v2FrameHdr ), dataBytes );
+  decodedFrame.resize( sizeof( ID3v2FrameHdr ) + dataBytes );
+
+  if( isCompressed )
+  {
+    if( inflateFunction_ == nullptr || prefixBytes < inflatedBytesPos + sizeof( uint32_t ) )
+      return false;
+    uint32_t sizeField = 0u;
+    memcpy( &sizeField, rawFrame + sizeof( ID3v2FrameHdr ) + inflatedBytesPos, sizeof( sizeField ) );
+    size_t inflatedBytes = isV3 ? ReadID3Int<8>( sizeField ) : ReadID3Int<7>( sizeField );
 
-  offset += static_cast<uint32_t>(GetFrameBytes( rawFrame, fileHeader_.GetMajorVersion() ));
+    std::vector<uint8_t> inflated;
+    auto compressed = std::span<const uint8_t>( decodedFrame ).subspan( sizeof( ID3v2FrameHdr ) );
+    if( !inflateFunction_( compressed, inflatedBytes, inflated ) )
+      return false;
+    decodedFrame.resize( sizeof( ID3v2FrameHdr ) );
+    decodedFrame.insert( decodedFrame.end(), inflated.begin(), inflated.end() );
+    dataBytes = inflated.size();
+  }
+
+  auto* decodedHdr = reinterpret_cast<ID3v2FrameHdr*>( decodedFrame.data() );
+  decodedHdr->SetSize( static_cast<uint32_t>( dataBytes ), encodedVersion );
+  decodedHdr->ClearFormatFlags();
   return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Compressed and encrypted frame data can't be read in place, unless the frame
+// was inflated when it was parsed
+
+bool Mp3TagData::IsOpaqueFrame( const ID3Frame& frame ) const
+{
+  if( frame.IsEncoded() )
+    return false;
+  const auto* frameHdr = reinterpret_cast<const ID3v2FrameHdr*>( frame.GetHeader() );
+  uint8_t majorVersion = fileHeader_.GetMajorVersion();
+  return frameHdr->IsCompressed( majorVersion ) || frameHdr->IsEncrypted( majorVersion );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Compressed ID3v2 frames are inflated by the application's zlib
+
+Mp3TagData::InflateFunction Mp3TagData::inflateFunction_ = nullptr; // static
+
+void Mp3TagData::SetInflateFunction( InflateFunction inflateFunction ) // static
+{
+  inflateFunction_ = inflateFunction;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // Process all the ID3 frames 
 
 void Mp3TagData::ParseID3Frames()
 {
-  // Build frame list
-  auto offset = 0u;
+  // v2.3 unsynchronization covers the whole tag, frame headers included, so
+  // it must be removed before frames can be found. In v2.4, it's per frame
+  // and frame sizes are unaffected, so each frame is decoded on first access
+  auto flags = fileHeader_.GetFlags();
+  bool isTagUnsynced = ( flags & ID3v2FileHeader::kFlagUnsynchronized );
+  if( isTagUnsynced && fileHeader_.GetMajorVersion() == kMajorVersionWith8BitSize )
+  {
+    id3FrameBuffer_.resize( RemoveUnsynchronization( id3FrameBuffer_.data(), id3FrameBuffer_.size() ) );
+    isTagUnsynced = false;
+  }
+
+  // Frames follow the extended header, if any. Write() emits frames without
+  // unsynchronization, extended header or footer, so the flags are dropped
+  auto offset = ( flags & ID3v2FileHeader::kFlagExtended ) ? GetExtendedHeaderBytes() : 0u;
+  fileHeader_.ClearFlags( ID3v2FileHeader::kFlagUnsynchronized | ID3v2FileHeader::kFlagExtended |
+                          ID3v2FileHeader::kFlagFooterPresent );
+
+  // Find padding up front so the walker stops at the last frame
+  auto paddingStart = static_cast<uint32_t>( GetPaddingStart( id3FrameBuffer_.data(), id3FrameBuffer_.size() ) );
+
+  // Choose the frame walker once per tag. Versions after 2.4 are assumed to
+  // keep 2.4 frame headers, as elsewhere
+  if( fileHeader_.GetMajorVersion() == kMajorVersionWith8BitSize )
+    ParseID3Frames<kMajorVersionWith8BitSize>( offset, paddingStart, isTagUnsynced );
+  else
+    ParseID3Frames<kMajorVersionWith8BitSize + 1>( offset, paddingStart, isTagUnsynced );
+  IndexID3Frames();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Build frame list; the version is a template parameter so size decoding in
+// this loop is resolved at compile time
+
+template <uint8_t kMajorVersion>
+void Mp3TagData::ParseID3Frames( uint32_t offset, uint32_t paddingStart, bool isTagUnsynced )
+{
   auto framesRemain = true;
   while( framesRemain )
-    framesRemain = ParseID3Frame( offset );
+    framesRemain = ParseID3Frame<kMajorVersion>( offset, paddingStart, isTagUnsynced );
+}
 
-  // Create sublists for common frame types
+///////////////////////////////////////////////////////////////////////////////
+//
+// Index common frame types, skipping deleted frames
+
+void Mp3TagData::IndexID3Frames()
+{
+  textFrameIndex_.fill( kInvalidFramePos );
+  commentFrames_.clear();
   for( size_t i = 0u; i < frames_.size(); ++i )
   {
-    if( frames_[i].IsTextFrame() )
-      textFrames_.emplace_back( i );
-    else if( frames_[i].IsCommentFrame() )
+    const ID3Frame& frame = frames_[i];
+    if( frame.IsDeleted() || IsOpaqueFrame( frame ) )
+      continue;
+    if( frame.IsTextFrame() )
+    {
+      auto frameType = GetFrameType( reinterpret_cast<const char*>( frame.GetHeader() ) );
+      if( frameType == Mp3FrameType::None )
+        continue;
+
+      // Duplicate text frames should never exist; first one wins
+      auto& framePos = textFrameIndex_[ static_cast<size_t>( frameType ) ];
+      if( framePos == kInvalidFramePos )
+        framePos = i;
+      else
+        PKLOG_WARN( "\nDuplicate frame %s in %S\n", GetFrameID(frameType).c_str(), path_.c_str());
+    }
+    else if( frame.IsCommentFrame() )
       commentFrames_.emplace_back( i );
   }
+  IndexComments();
+  IndexUserText();
+  for( auto frameType : kNumericFrameTypes )
+    ParseNumericField( frameType );
+  ClearTextCache();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Index comments by description. Descriptions are decoded once here so
+// FindComment() never decodes
+
+void Mp3TagData::IndexComments()
+{
+  commentIndex_.clear();
+  commentCache_.clear();
+  for( auto framePos : commentFrames_ )
+  {
+    const ID3Frame& frame = frames_[ framePos ];
+    const auto* commentFrame = reinterpret_cast<const ID3v2CommentFrame*>( frame.GetData() );
+    auto view = commentFrame->GetView( fileHeader_.GetMajorVersion() );
+    commentIndex_.emplace( view.GetDescription(), framePos );
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Index TXXX frames by description; values aren't decoded until requested.
+// Duplicate descriptions are invalid; first one wins
 
-  // Check for duplicate text frames, which should never exist
-  for( auto frameType = Mp3FrameType::First; frameType != Mp3FrameType::Comment; ++frameType )
+void Mp3TagData::IndexUserText()
+{
+  userTextIndex_.clear();
+  for( size_t i = 0u; i < frames_.size(); ++i )
   {
-    [[maybe_unused]] size_t count = 0;
-    for( auto i : textFrames_ )
-      if( frames_[ i ].IsFrameID( frameType ) )
-        ++count;
-    if( count > 1 )
-      PKLOG_WARN( "\nDuplicate frame %s in %S\n", GetFrameID(frameType).c_str(), path_.c_str());
+    const ID3Frame& frame = frames_[ i ];
+    if( frame.IsDeleted() || !frame.IsUserTextFrame() || IsOpaqueFrame( frame ) )
+      continue;
+    const auto* userTextFrame = reinterpret_cast<const ID3v2UserTextFrame*>( frame.GetData() );
+    auto view = userTextFrame->GetView( fileHeader_.GetMajorVersion() );
+    if( !userTextIndex_.emplace( view.GetDescription(), i ).second )
+      PKLOG_WARN( "\nDuplicate TXXX %s in %S\n", view.GetDescription().c_str(), path_.c_str() );
   }
 }
 
@@ -412,19 +1756,32 @@ void Mp3TagData::ParseID3Frames()
 
 bool Mp3TagData::ParseAPETag( uint32_t& offset )
 {
-  // Safety check: if unexpected end of the tag section, something is wrong
-  // so bail out
-  if( offset >= apeFrameBuffer_.size() )
+  // Safety check: items end at the footer, so an item that doesn't fit in
+  // front of it means something is wrong; bail out
+  size_t itemsEnd = apeFrameBuffer_.size() - sizeof( APEv2TagHeader );
+  if( offset + sizeof( APEv2TagItem ) > itemsEnd )
     return false;
-  
-  // Archive the tag for future reference
+
   const auto* rawTag = apeFrameBuffer_.data() + offset;
+  const auto* apeTagItem = reinterpret_cast<const APEv2TagItem*>( rawTag );
+  size_t keyStart = offset + sizeof( APEv2TagItem ) - sizeof( '\0' );
+  std::string_view key = apeTagItem->GetKeyView( itemsEnd - keyStart );
+  if( key.empty() )
+    return false;
+  uint64_t itemBytes = uint64_t( sizeof( APEv2TagItem ) ) + key.size() + apeTagItem->GetValueSize();
+  if( offset + itemBytes > itemsEnd )
+    return false;
+
+  // Archive the tag for future reference
   APETag tag( rawTag );
   apeTags_.emplace_back( tag );
 
+  // Index by key; keys are unique per the spec, so first one wins if not.
+  // The key view points into apeFrameBuffer_, so no string is built
+  apeIndex_.emplace( key, apeTags_.size() - 1 );
+
   // Determine where to find the next tag
-  const auto* apeTagItem = reinterpret_cast<const APEv2TagItem*>( rawTag );
-  offset += apeTagItem->GetTagSize();
+  offset += static_cast<uint32_t>( itemBytes );
   return true;
 }
 
@@ -435,25 +1792,32 @@ bool Mp3TagData::ParseAPETag( uint32_t& offset )
 
 void Mp3TagData::ParseAPETags()
 {
-  if( apeFrameBuffer_.empty() )
+  if( apeFrameBuffer_.size() < sizeof( APEv2TagHeader ) )
     return;
 
-  // Validate the header
-  const auto* rawTag = apeFrameBuffer_.data();
-  const auto* apeTagHeader = reinterpret_cast<const APEv2TagHeader*>( rawTag );
-  assert(apeTagHeader->IsHeader());
+  // The footer is always present; the header is optional (and absent in APEv1)
+  const auto* rawTag = apeFrameBuffer_.data() + apeFrameBuffer_.size() - sizeof( APEv2TagHeader );
+  const auto* apeTagFooter = reinterpret_cast<const APEv2TagHeader*>( rawTag );
+  assert( !apeTagFooter->IsHeader() );
 
   // Build tag item list
-  uint32_t offset = sizeof(APEv2TagHeader);
-  for( auto itemCount = apeTagHeader->GetItemCount(); itemCount; --itemCount )
-    if( !ParseAPETag(offset) )
-      break;
-
-  // Validate the footer
-  assert( offset == apeTagHeader->GetTagSize());
-  rawTag = apeFrameBuffer_.data() + offset;
-  [[maybe_unused]] const auto* apeTagFooter = reinterpret_cast<const APEv2TagHeader*>( rawTag );
-  assert( !apeTagFooter->IsHeader() );
+  uint32_t offset = apeTagFooter->ContainsHeader() ? sizeof( APEv2TagHeader ) : 0u;
+  // The item count comes from the file; don't reserve more than can fit
+  size_t maxItems = apeFrameBuffer_.size() / APEv2TagItem::kMinItemSize;
+  apeTags_.reserve( std::min<size_t>( apeTagFooter->GetItemCount(), maxItems ) );
+  apeIndex_.reserve( std::min<size_t>( apeTagFooter->GetItemCount(), maxItems ) );
+  bool isValid = true;
+  for( auto itemCount = apeTagFooter->GetItemCount(); itemCount && isValid; --itemCount )
+    isValid = ParseAPETag( offset );
+
+  // Items should end exactly at the footer; if not, none of them can be trusted
+  if( !isValid || offset != apeFrameBuffer_.size() - sizeof( APEv2TagHeader ) )
+  {
+    PKLOG_WARN( "\nMalformed APE tag in %S; ignoring its items\n", path_.c_str() );
+    apeTags_.clear();
+    apeIndex_.clear();
+  }
+  IndexAPEFields();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -480,62 +1844,101 @@ uint32_t Mp3TagData::GetFrameBytes( const uint8_t* rawFrame, uint8_t version ) /
 
 ///////////////////////////////////////////////////////////////////////////////
 //
-// Locate APE header in the MP3 file
+// Extract the number of bytes represented by this APE tag item
+
+uint32_t Mp3TagData::GetAPETagBytes( const uint8_t* rawTag ) // static
+{
+  assert( rawTag != nullptr );
+  const auto* apeTagItem = reinterpret_cast<const APEv2TagItem*>( rawTag );
+  return apeTagItem->GetTagSize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Load the APE and ID3v1 tags from the end of the file
 //
-// Typically found near or at the end of the file. Search in chunks to maximize
-// speed. Returns the file offset of the APE header, or kNoApeHeader if not found.
+// One bounded read of the file tail finds both the ID3v1 tag (always the last
+// 128 bytes) and the APE footer (immediately before ID3v1, or at the end of the
+// file). Only an APE tag larger than the window requires a second read.
 
-uint64_t Mp3TagData::FindApeHeaderOffset( File& mp3File ) const
+bool Mp3TagData::LoadTail( File& mp3File )
 {
-  auto fileSize = mp3File.GetLength();
-  auto filePos = ( kBacktrackBufferSize > fileSize ) ? 0u : fileSize - kBacktrackBufferSize;
-  std::string searchBuffer;
-  searchBuffer.resize( kBacktrackBufferSize );
-  uint32_t bytesRead = 0u;
-  auto findPos = std::string::npos;
-  auto tagLength = std::string( kApeTag ).size();
-  uint32_t readLength = kBacktrackBufferSize;
+  // A truncated ID3v2 tag claims to end past the end of the file. Leave no
+  // audio rather than an end offset before the start
+  uint64_t fileSize = mp3File.GetLength();
+  audioEndOffset_ = std::max<uint64_t>( fileSize, audioBufferOffset_ );
+  if( fileSize < audioBufferOffset_ )
+    PKLOG_WARN( "\nSong %S has a truncated ID3v2 tag; no audio\n", path_.c_str() );
+  if( fileSize <= audioBufferOffset_ )
+    return true;
+
+  // Never read back into the ID3v2 section
+  auto windowSize = static_cast<size_t>( std::min( kTailWindowSize, fileSize - audioBufferOffset_ ) );
+  uint64_t windowStart = fileSize - windowSize;
+  std::vector<uint8_t> window( windowSize );
+  if( !mp3File.SetPos( windowStart ) ||
+      !mp3File.Read( window.data(), static_cast<uint32_t>( windowSize ) ) )
+  {
+    PKLOG_WARN( "Failed to read tail tags from %S; ERR: %d\n", path_.c_str(), Util::GetLastError() );
+    return false;
+  }
 
-  while( findPos == std::string::npos && filePos > 0 )
+  // ID3v1
+  uint64_t tailEnd = fileSize;
+  if( windowSize >= ID3v1Tag::kTagSize )
   {
-    // Read the search buffer from the MP3 file
-    mp3File.SetPos( filePos );
-    if( !mp3File.Read( searchBuffer.data(), readLength, bytesRead ) )
+    const uint8_t* rawID3v1 = window.data() + windowSize - ID3v1Tag::kTagSize;
+    if( ID3v1Tag::IsTag( rawID3v1 ) )
     {
-      PKLOG_WARN( "Failed to read MP3 APE frames from %S; ERR: %d\n", path_.c_str(), Util::GetLastError() );
-      return kNoApeHeader;
+      memcpy( &id3v1Tag_, rawID3v1, ID3v1Tag::kTagSize );
+      hasID3v1_ = true;
+      tailEnd -= ID3v1Tag::kTagSize;
     }
+  }
 
-    findPos = searchBuffer.find( kApeTag );
-    if( findPos != std::string::npos )
+  // APE footer
+  if( tailEnd - windowStart >= sizeof( APEv2TagHeader ) )
+  {
+    const uint8_t* rawFooter = window.data() + ( tailEnd - windowStart - sizeof( APEv2TagHeader ) );
+    const auto* apeTagFooter = reinterpret_cast<const APEv2TagHeader*>( rawFooter );
+    if( memcmp( rawFooter, kApeTag, APEv2TagHeader::kApeIDSize ) == 0 && !apeTagFooter->IsHeader() )
     {
-      // Found the APE header
-      uint64_t apeStart = filePos + findPos;
-      return apeStart;
+      // Tag size includes the footer but not the header
+      uint64_t apeBytes = apeTagFooter->GetTagSize();
+      if( apeTagFooter->ContainsHeader() )
+        apeBytes += sizeof( APEv2TagHeader );
+      if( apeBytes < sizeof( APEv2TagHeader ) || apeBytes > tailEnd - audioBufferOffset_ )
+      {
+        PKLOG_WARN( "\nSong %S has malformed APE footer; ignored\n", path_.c_str() );
+        audioEndOffset_ = tailEnd;
+        return true;
+      }
+
+      apeStart_ = tailEnd - apeBytes;
+      apeFrameBuffer_.resize( static_cast<size_t>( apeBytes ) );
+      if( apeStart_ >= windowStart )
+      {
+        memcpy( apeFrameBuffer_.data(), window.data() + ( apeStart_ - windowStart ), apeFrameBuffer_.size() );
+      }
+      else if( !mp3File.SetPos( apeStart_ ) ||
+               !mp3File.Read( apeFrameBuffer_.data(), static_cast<uint32_t>( apeBytes ) ) )
+      {
+        PKLOG_WARN( "Failed to read APE tags from %S; ERR: %d\n", path_.c_str(), Util::GetLastError() );
+        return false;
+      }
+      tailEnd = apeStart_;
     }
-
-    // Keep searching
-    if( kBacktrackBufferSize > filePos )
-      filePos = 0u;
-    else
-      filePos -= kBacktrackBufferSize;
-
-    // For all searches after the first, include the tag length in the buffer
-    // to detect scenarios where the tag is on the border of the two backtrackBuffers
-    readLength = uint32_t( kBacktrackBufferSize + tagLength );
-    searchBuffer.resize( readLength );
   }
 
-  // Searched the entire file and no APE header
-  return kNoApeHeader;
+  audioEndOffset_ = tailEnd;
+  return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //
 // Locate text frame
 //
-// There are on order of a couple dozen of frames in a typical MP3 file and rarely
-// more than 100, so linear search is fine
+// Text frames are indexed by type at parse time, so this is a single lookup
 
 const Mp3TagData::ID3Frame* Mp3TagData::GetTextFrame( Mp3FrameType frameType ) const
 {
@@ -548,14 +1951,130 @@ const Mp3TagData::ID3Frame* Mp3TagData::GetTextFrame( Mp3FrameType frameType ) c
 size_t Mp3TagData::GetTextFrameReferencePos( Mp3FrameType frameType ) const
 {
   assert( IsTextFrame( frameType ) );
-  auto it = std::ranges::find_if( textFrames_, [ &frames_ = frames_, frameType ]( size_t pos )
+  return textFrameIndex_[ static_cast<size_t>( frameType ) ];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Reset the per-type lookup tables
+
+void Mp3TagData::ClearIndexes()
+{
+  textFrameIndex_.fill( kInvalidFramePos );
+  apeFieldIndex_.fill( kInvalidFramePos );
+  numericFields_.fill( NumericField{} );
+  ClearTextCache();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Drop all decoded text; the next GetText()/GetComment() decodes again
+
+void Mp3TagData::ClearTextCache()
+{
+  textCache_.fill( std::nullopt );
+  commentCache_.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Map each frame type to the APE item with the conventional key for that field
+
+void Mp3TagData::IndexAPEFields()
+{
+  for( auto frameType = Mp3FrameType::First; frameType != Mp3FrameType::Max; ++frameType )
+  {
+    std::string_view key = kApeItemKey.at( frameType );
+    auto it = key.empty() ? std::end( apeIndex_ ) : apeIndex_.find( key );
+    apeFieldIndex_[ static_cast<size_t>( frameType ) ] = 
+      ( it == std::end( apeIndex_ ) ) ? kInvalidFramePos : it->second;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Locate APE tag by key; hashed, so this is independent of the number of tags
+
+const Mp3TagData::APETag* Mp3TagData::GetAPETag( std::string_view key ) const
+{
+  auto it = apeIndex_.find( key );
+  if( it == std::end( apeIndex_ ) )
+    return nullptr;
+  return &( apeTags_[ it->second ] );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Create or replace an APE item. The index is keyed by a view into the item
+// data, so the entry is re-added once the new item has been built. Read-only
+// items are left alone; a replaced item keeps its flags.
+
+void Mp3TagData::SetAPEItem( std::string_view key, std::span<const uint8_t> value, bool isBinary )
+{
+  assert( !key.empty() );
+  auto it = apeIndex_.find( key );
+  uint32_t flags = 0u;
+  if( it != std::end( apeIndex_ ) )
+  {
+    const APETag& existingTag = apeTags_[ it->second ];
+    const auto* existingItem = reinterpret_cast<const APEv2TagItem*>( existingTag.GetData() );
+    if( existingItem->IsReadOnly() )
     {
-      return frames_[ pos ].IsFrameID( frameType );
-    } );
-  if( it != std::end( textFrames_) )
-    return *it; // position index
+      PKLOG_WARN( "\nAPE item %s in %S is read-only; not changed\n", existingItem->GetKey().c_str(), path_.c_str() );
+      return;
+    }
+    flags = existingItem->GetFlags();
+  }
+
+  if( value.empty() )
+  {
+    DeleteAPETag( key );
+    return;
+  }
+
+  TagPos tagPos;
+  std::string existingKey;
+  if( it == std::end( apeIndex_ ) )
+  {
+    // Item isn't in MP3 file; create new item
+    apeTags_.emplace_back( APETag{} );
+    tagPos = apeTags_.size() - 1;
+  }
+  else
+  {
+    // Preserve the original spelling of the key
+    tagPos = it->second;
+    existingKey = it->first;
+    key = existingKey;
+    apeIndex_.erase( it );
+  }
+  APETag* pTag = &( apeTags_[ tagPos ] );
+
+  // Create an item of the proper size
+  pTag->Allocate( APEv2TagItem::GetItemSize( key, value.size() ) );
+  auto* pItem = reinterpret_cast<APEv2TagItem*>( pTag->GetData() );
+  pItem->SetItem( key, value, isBinary, flags );
+
+  apeIndex_.emplace( pItem->GetKeyView(), tagPos );
+  IndexAPEFields();
+  isTailDirty_ = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Flag the given APE item for deletion. The item remains in apeTags_, but is
+// no longer indexed, so it isn't available for future lookups
+
+void Mp3TagData::DeleteAPETag( std::string_view key )
+{
+  auto it = apeIndex_.find( key );
+  if( it == std::end( apeIndex_ ) )
+    return;
 
-  return kInvalidFramePos;
+  apeTags_[ it->second ].FlagToDelete();
+  apeIndex_.erase( it );
+  IndexAPEFields();
+  isTailDirty_ = true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -582,19 +2101,24 @@ size_t Mp3TagData::GetCommentFrameReferencePos( size_t i ) const
 ///////////////////////////////////////////////////////////////////////////////
 //
 // Flag the given frame for deletion. The frame remains in mFrames, so we know 
-// to delete it during Write(), but the frame is removed from mTextFrames, 
+// to delete it during Write(), but the frame is removed from textFrameIndex_, 
 // since it shouldn't be available for future GetText()s
 
 void Mp3TagData::DeleteTextFrame( Mp3FrameType frameType )
 {
+  // Clear the matching ID3v1 field too; otherwise GetText() falls back to it
+  // and the deleted field reappears
+  if( hasID3v1_ && !GetID3v1Text( frameType ).empty() )
+    SetID3v1Text( frameType, std::string() );
+
   auto framePos = GetTextFrameReferencePos( frameType );
   if( framePos == kInvalidFramePos )
     return;
 
   frames_[ framePos ].FlagToDelete();
-  auto pos = std::ranges::find( textFrames_, framePos );
-  if( pos != textFrames_.end() )
-    textFrames_.erase( pos );
+  textFrameIndex_[ static_cast<size_t>( frameType ) ] = kInvalidFramePos;
+  ParseNumericField( frameType ); // may fall back to ID3v1
+  textCache_[ static_cast<size_t>( frameType ) ].reset();
   isDirty_ = true;
 }
 
@@ -615,6 +2139,7 @@ void Mp3TagData::DeleteCommentFrame( size_t i )
   auto pos = std::ranges::find( commentFrames_, framePos );
   if ( pos != commentFrames_.end() )
     commentFrames_.erase( pos );
+  IndexComments();
   isDirty_ = true;
 }
 
@@ -715,13 +2240,23 @@ std::ostream& PKIsensee::operator<<( std::ostream& out, const Mp3TagData& tagDat
     }
   }
 
+  if( tagData.hasID3v1_ )
+  {
+    const ID3v1Tag& v1 = tagData.id3v1Tag_;
+    out << "ID3v1: " << PrintText( v1.GetTitle() ) << ' ' << PrintText( v1.GetArtist() ) << ' ';
+    out << PrintText( v1.GetAlbum() ) << ' ' << PrintText( v1.GetYear() ) << ' ';
+    out << "Trk:" << +v1.GetTrack() << " Gen:" << +v1.GetGenre() << '\n';
+  }
+
   // Output APE tags
   for( const auto& t : tagData.apeTags_ )
   {
+    if( t.IsDeleted() )
+      continue;
     const auto* rawTag = t.GetData();
     const auto* apeTag = reinterpret_cast<const APEv2TagItem*>( rawTag );
     out << "APE: Siz:" << apeTag->GetTagSize() << ' ';
-    out << PrintKey(apeTag->GetKey()) << ' ';
+    out << PrintKey( apeTag->GetKey() ) << ' ';
     out << ( apeTag->IsText() ? PrintText(apeTag->GetText()) :
                                 PrintBlob(apeTag->GetData()) );
     if( apeTag->IsReadOnly() )
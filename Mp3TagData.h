@@ -15,21 +15,105 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #pragma once
+#include <array>
 #include <filesystem>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "ID3v1Frames.h"
+#include "ID3v2Timeline.h"
 #include "Mp3BaseTagData.h"
+#include "MpegFrames.h"
 
 namespace PKIsensee
 {
 
+// Places a field can come from when resolving across tag types
+enum class Mp3TagSource
+{
+  ID3v2,
+  APE,
+  ID3v1,
+  Max
+};
+
+constexpr size_t kMaxTagSources = static_cast<size_t>( Mp3TagSource::Max );
+
+// Where gapless playback information was found
+enum class Mp3GaplessSource
+{
+  None,
+  iTunSMPB,  // COMM frame with the description "iTunSMPB"
+  LameHeader // LAME extension to the Xing/Info header
+};
+
+// Track or disc position, e.g. TRCK "5/12"
+struct Mp3TrackNumber
+{
+  uint32_t number = 0u;
+  uint32_t total = 0u; // zero if not specified
+};
+
+// Order in which ID3v2 frames are written
+enum class Mp3FrameOrder
+{
+  Preserve,   // existing order; new frames at the end
+  CommonFirst // TIT2, TPE1, TALB, TRCK, TCON first; APIC, GEOB, PRIV last
+};
+
+// Outcome of Mp3TagData::SyncTagsTo()
+enum class Mp3SyncResult
+{
+  Unchanged,    // replica tags already match
+  TagsSynced,   // replica tags rewritten
+  AudioDiffers, // replica audio isn't the same; needs a full copy
+  Failed
+};
+
+// Samples to trim for gapless playback, as stored by the encoder. Decoders add
+// their own delay on top of encoderDelay (529 samples for typical MP3 decoders)
+struct Mp3GaplessInfo
+{
+  uint32_t encoderDelay = 0u;   // samples to skip at the start
+  uint32_t encoderPadding = 0u; // samples to skip at the end
+  uint64_t sampleCount = 0u;    // playable samples, excluding delay and padding; zero if unknown
+  Mp3GaplessSource source = Mp3GaplessSource::None;
+};
+
+// Any ID3v2 frame, as views into the frame data; see Mp3TagData::GetFrames()
+struct Mp3FrameRef
+{
+  std::string_view id;              // e.g. "UFID"
+  uint16_t flags = 0u;              // status flags in the high byte, format flags in the low byte
+  uint32_t size = 0u;               // payload bytes
+  std::span<const uint8_t> payload; // frame contents following the header
+};
+
 class Mp3TagData : public Mp3BaseTagData
 {
 public:
 
-  Mp3TagData() {}
+  Mp3TagData();
   bool LoadTagData( const std::filesystem::path& );
 
+  // Like LoadTagData(), but also succeeds for a file with no tags, whose audio
+  // is the whole file; fails only if the file can't be read or its ID3v2
+  // header is invalid. Use before audio-only operations such as GetAudioHash()
+  bool LocateAudio( const std::filesystem::path& );
+
+  // Decompresses zlib data into inflated, e.g. a wrapper around zlib's
+  // uncompress(); inflatedBytes is the size given by the frame. This library
+  // doesn't link zlib, so without a function compressed ID3v2 frames are kept
+  // as-is and not indexed. Set once before loading any files
+  using InflateFunction = bool(*)( std::span<const uint8_t> compressed, size_t inflatedBytes,
+                                   std::vector<uint8_t>& inflated );
+  static void SetInflateFunction( InflateFunction );
+
   Mp3TagData( const Mp3TagData& ) = delete;
   Mp3TagData& operator=( const Mp3TagData& ) = delete;
   Mp3TagData( Mp3TagData&& ) = delete;
@@ -40,39 +124,262 @@ public:
     return frames_.size();
   }
 
-  // Extract string from text frame
+  // Iterates all ID3v2 frames in tag order, skipping deleted frames; no
+  // decoding or allocation. Invalidated by any Set*() or Delete*() call
+  class FrameIterator
+  {
+  private:
+    const Mp3TagData* tagData_ = nullptr;
+    size_t framePos_ = 0u;
+
+    void SkipDeleted();
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Mp3FrameRef;
+    using difference_type = std::ptrdiff_t;
+
+    FrameIterator() = default;
+    FrameIterator( const Mp3TagData*, size_t framePos );
+
+    Mp3FrameRef operator*() const;
+    FrameIterator& operator++();
+    FrameIterator operator++( int );
+
+    bool operator==( const FrameIterator& rhs ) const
+    {
+      return framePos_ == rhs.framePos_;
+    }
+  };
+
+  class FrameRange
+  {
+  private:
+    const Mp3TagData* tagData_ = nullptr;
+
+  public:
+    explicit FrameRange( const Mp3TagData* tagData )
+      : tagData_( tagData )
+    {
+    }
+
+    FrameIterator begin() const;
+    FrameIterator end() const;
+  };
+
+  FrameRange GetFrames() const;
+
+  // First frame with the given ID, e.g. "UFID" or "TXXX"; use GetFrames()
+  // for frames that may repeat
+  std::optional<Mp3FrameRef> GetFrame( std::string_view frameID ) const;
+
+  // Extract string from text frame. Decodes on every call unless GetTextRef()
+  // has cached the value; doesn't write the cache, so it's safe to call from
+  // multiple threads on the same object
   std::string GetText( Mp3FrameType ) const final;
 
-  // Extract comment at given position
+  // Extract comment at given position; decodes like GetText()
   size_t GetCommentCount() const final;
   std::string GetComment( size_t index=0 ) const final;
 
-  // Set text frame string; an empty string removes the frame
+  // Decoded values are cached, so repeated calls don't decode again. The
+  // references are valid until the field is set or deleted, or the tags are
+  // reloaded. Because of the cache, these and GetText<>() aren't safe to call
+  // from multiple threads on the same object, even though they're const
+  const std::string& GetTextRef( Mp3FrameType ) const;
+  const std::string& GetCommentRef( size_t index=0 ) const;
+
+  // Decode into a caller-owned string, reusing its capacity, e.g. one string
+  // per column when exporting many files. The Append forms add to the end of
+  // out, e.g. to pack many fields into one buffer, and return the bytes added.
+  // These don't fill the cache used by GetTextRef()
+  void GetText( Mp3FrameType, std::string& out ) const;
+  void GetComment( size_t index, std::string& out ) const;
+  size_t AppendText( Mp3FrameType, std::string& out ) const;
+  size_t AppendComment( size_t index, std::string& out ) const;
+
+  // Compile-time variant of GetTextRef(), e.g. GetText<Mp3FrameType::Title>().
+  // The frame ID, text vs. comment frame and index slot are fixed by the
+  // template argument, so a cached value is a single indexed load.
+  // Mp3FrameType::Comment returns the first comment. Shares the cache and
+  // the reference lifetime of GetTextRef()
+  template <Mp3FrameType kFrameType>
+  const std::string& GetText() const;
+
+  // Set text frame string; an empty string removes the frame and clears the
+  // matching ID3v1 field, so GetText() doesn't fall back to the old value
   void SetText( Mp3FrameType, const std::string& ) final;
 
+  // Split a multi-valued text frame, e.g. TPE1 "Band A/Band B", into views of
+  // the frame data without allocating. Values are null separated, and also '/'
+  // separated if splitOnSlash. Views are invalidated by SetText() on the frame.
+  // Unlike GetText(), there's no fallback to the ID3v1 tag
+  ID3v2TextValues GetTextValues( Mp3FrameType, bool splitOnSlash = true ) const;
+
   // Set comment frame string; an empty string removes the frame
   // A string at position GetCommentCount() adds a new comment
   void SetComment( size_t index, const std::string& ) final;
 
+  // Language, description and text of the comment at the given position as
+  // views into the frame data; invalidated by SetComment()
+  ID3v2CommentView GetCommentView( size_t index ) const;
+
+  // Comment with the given description, e.g. "iTunNORM", and language, e.g.
+  // "eng"; an empty language matches any. Uses an index built at load time,
+  // so comments aren't decoded during the search
+  std::optional<ID3v2CommentView> FindComment( std::string_view description,
+                                               std::string_view language = {} ) const;
+
+  // User-defined text (TXXX) by description, e.g. "REPLAYGAIN_TRACK_GAIN";
+  // descriptions match ignoring case. Values are decoded only when requested
+  std::string GetUserText( std::string_view description ) const;
+  std::optional<ID3v2UserTextView> FindUserText( std::string_view description ) const;
+
+  // Set user-defined text frame; an empty value removes the frame
+  void SetUserText( const std::string& description, const std::string& value );
+
+  // Numeric fields, parsed once when the tags are loaded or the field is set,
+  // so they're cheap enough for sort comparisons. Empty if the field is missing
+  // or doesn't start with a number. Fall back to ID3v1 like GetText()
+  std::optional<Mp3TrackNumber> GetTrack() const; // TRCK
+  std::optional<uint32_t> GetYear() const;        // TYER
+  std::optional<uint32_t> GetOrigYear() const;    // TORY
+  std::optional<uint32_t> GetBpm() const;         // TBPM; integer part
+  std::optional<uint32_t> GetDurationMs() const;  // TLEN
+
   // Location in file where to start looking for MPEG audio data
   uint32_t GetAudioBufferOffset() const;
 
+  // Look up APE item by key, e.g. "REPLAYGAIN_TRACK_GAIN"; keys are case-insensitive
+  bool HasAPEItem( std::string_view key ) const;
+  std::string GetAPEText( std::string_view key ) const;
+  std::span<const uint8_t> GetAPEData( std::string_view key ) const;
+
+  // Location in file where tail tags (APE, ID3v1) begin; end of MPEG audio data
+  uint64_t GetAudioEndOffset() const;
+
+  // Scan the start of the MPEG audio for format, bitrate and duration. Reads a
+  // few KB at GetAudioBufferOffset(); duration is exact when the encoder wrote
+  // a Xing/Info or VBRI frame, otherwise estimated assuming CBR
+  bool LoadAudioInfo();
+  const MpegAudioInfo& GetAudioInfo() const;
+
+  // Build a time-to-byte seek table, calling LoadAudioInfo() if needed. Uses
+  // the Xing TOC when present and preferToc is set; otherwise reads every frame
+  // header and records every Nth frame, which also makes the duration exact.
+  // Serialize the table to cache it; SetSeekTable() restores a cached table
+  // and rejects it if the audio has moved or changed size
+  bool BuildSeekTable( bool preferToc = true,
+                       uint32_t framesPerEntry = MpegSeekTable::kDefaultFramesPerEntry );
+  bool SetSeekTable( std::span<const uint8_t> serializedTable );
+  const MpegSeekTable& GetSeekTable() const;
+
+  // 64-bit XXH64 hash of the audio payload only, so it's unaffected by tag edits.
+  // GetAudioHashes() hashes many files on a pool of threads; maxThreads of zero
+  // means one per core, and an entry is empty if that file couldn't be read
+  bool GetAudioHash( uint64_t& hash ) const;
+  static std::vector<std::optional<uint64_t>> GetAudioHashes(
+    std::span<const std::filesystem::path>, uint32_t maxThreads = 0u );
+
+  // Find encoder delay and padding. An iTunSMPB comment is used if present,
+  // since it needs no further I/O; otherwise the LAME header is read via
+  // LoadAudioInfo(). The result is kept until the tags are reloaded
+  bool LoadGaplessInfo();
+  const Mp3GaplessInfo& GetGaplessInfo() const;
+
+  // Synchronized lyrics/text (SYLT) and chapters (CHAP/CTOC), decoded once into
+  // arrays sorted by time, so "lyric at t" and "chapter containing t" are binary
+  // searches. LoadSyncedText() takes the first SYLT frame in the given language,
+  // or any language if empty; timestamps in MPEG frames call LoadAudioInfo().
+  // Results are kept until the tags are reloaded
+  bool LoadSyncedText( std::string_view language = {} );
+  const ID3v2SyncedText& GetSyncedText() const;
+  bool LoadChapters();
+  const ID3v2Chapters& GetChapters() const;
+
+  // Write the audio payload alone to a new file, dropping ID3v2, APE and ID3v1
+  // tags. If withID3v2Tag is set, the audio is preceded by an unpadded ID3v2 tag
+  // serialized from this object's frames, including unsaved edits
+  bool WriteAudioCopy( const std::filesystem::path& destPath, bool withID3v2Tag = false ) const;
+
+  // Copy this object's tags, including unsaved edits, to a replica of the file
+  // without transferring its audio. The audio must be the same size and, if
+  // verifyAudioHash is set, have the same hash. Size alone is only a heuristic:
+  // a same-length re-encode or edit passes it, so clear verifyAudioHash only
+  // when the replica is known to hold the same audio
+  Mp3SyncResult SyncTagsTo( const std::filesystem::path& replicaPath, bool verifyAudioHash = true ) const;
+
+  // ID3v1 tag fields (Title, Artist, Album, Year, TrackNum, Genre);
+  // GetText() falls back to these when there's no matching ID3v2 frame
+  bool HasID3v1Tag() const;
+  std::string GetID3v1Text( Mp3FrameType ) const;
+  std::string GetID3v1Comment() const;
+
+  // Set ID3v1 field, creating the ID3v1 tag if needed; values are truncated to fit
+  void SetID3v1Text( Mp3FrameType, const std::string& );
+  void SetID3v1Comment( const std::string& );
+  void RemoveID3v1Tag();
+
+  // Resolve a field across ID3v2, APE and ID3v1 tags in precedence order;
+  // default order is ID3v2, APE, ID3v1. ResolveUserText() takes an APE-style
+  // key for fields without an Mp3FrameType, e.g. "REPLAYGAIN_TRACK_GAIN"
+  using SourceOrder = std::array<Mp3TagSource, kMaxTagSources>;
+  void SetSourcePrecedence( const SourceOrder& );
+  std::string ResolveText( Mp3FrameType ) const;
+  std::string ResolveUserText( std::string_view key ) const;
+
+  // Set APE item; an empty value removes the item. Text values are UTF-8.
+  // APE and ID3v1 tags are rewritten in place at the end of the file by Write()
+  void SetAPEText( std::string_view key, const std::string& );
+  void SetAPEData( std::string_view key, std::span<const uint8_t> );
+
+  // Copy frames from another tag as raw bytes, replacing any frames with the
+  // same IDs. Unknown and binary frames are copied like any other. An empty
+  // filter copies every frame. Returns the number of frames copied
+  size_t CopyFramesFrom( const Mp3TagData&, std::span<const std::string_view> frameIDs = {} );
+  size_t CopyFramesFrom( const Mp3TagData&, std::span<const Mp3FrameType> );
+
+  // Frame order used by Write() and other functions that serialize the ID3v2
+  // tag. CommonFirst lets readers get the common fields from the first few KB
+  // of the file; it has no cost when the tag is being rewritten anyway
+  void SetFrameOrder( Mp3FrameOrder );
+
   // Write frame data if there have been changes
   bool Write() final;
   bool IsDirty() const final
   {
-    return isDirty_;
+    return isDirty_ || isTailDirty_;
   }
 
 private:
 
   bool IsValidFileHeader() const;
-  bool ParseID3Frame( uint32_t& offset );
+  template <uint8_t kMajorVersion> bool ParseID3Frame( uint32_t& offset, uint32_t paddingStart, bool isTagUnsynced );
+  template <uint8_t kMajorVersion> void ParseID3Frames( uint32_t offset, uint32_t paddingStart, bool isTagUnsynced );
+  uint32_t GetExtendedHeaderBytes() const;
   void ParseID3Frames();
+  void IndexID3Frames();
+  void IndexComments();
+  void IndexUserText();
+  Mp3FrameRef GetFrameRef( size_t framePos ) const;
+  void ParseNumericField( Mp3FrameType );
+  std::string DecodeText( Mp3FrameType ) const;
+  void ClearTextCache();
+  std::optional<uint32_t> GetNumericField( Mp3FrameType ) const;
   bool ParseAPETag( uint32_t& offset );
   void ParseAPETags();
   static uint32_t GetFrameSize( const uint8_t* rawFrame, uint8_t version );
   static uint32_t GetFrameBytes( const uint8_t* rawFrame, uint8_t version );
+  static uint32_t GetAPETagBytes( const uint8_t* rawTag );
+  bool WriteID3Frames();
+  bool WriteTail();
+  size_t GetID3FrameSectionSize() const;
+  void SerializeID3Tag( size_t padBytes, std::vector<uint8_t>& id3Tag ) const;
+  void SerializeTail( std::vector<uint8_t>& tail ) const;
+  static bool WriteID3Section( const std::filesystem::path&, uint64_t audioOffset,
+                               const std::vector<uint8_t>& id3Tag );
+  static bool WriteTailAt( const std::filesystem::path&, uint64_t tailStart,
+                           const std::vector<uint8_t>& tail );
 
   ///////////////////////////////////////////////////////////////////////////
   //
@@ -85,6 +392,13 @@ private:
   // newFrame is a new or updated frame; it supercedes rawFrame when it has
   // size > 1; size == 1 (kFlaggedForDelete) means frame flagged for delete.
   //
+  // If rawFrame is unsynchronized, compressed (with an inflate function set) or
+  // has a group ID or data length prefix, encodedVersion is nonzero and
+  // decodedFrame holds a plain copy, built the first time the data is
+  // requested. Loading indexes COMM, TXXX and numeric text frames, so those are
+  // decoded at load; compressed frames are also inflated at load, so a frame
+  // that fails to inflate is kept as-is.
+  //
   // Safe to cast rawFrame or newFrame.data() to ID3v2FrameHdr*
 
   struct ID3Frame
@@ -95,10 +409,16 @@ private:
 
     RawFramePtr rawFrame = nullptr;
     FrameBuf    newFrame;
+    mutable FrameBuf decodedFrame;
+    uint8_t     encodedVersion = 0u; // tag major version if rawFrame needs decoding
+    bool        isTagUnsynchronized = false;
+
+    bool BuildDecodedFrame() const;
 
     static constexpr uint32_t kFlaggedForDelete = 1;
     static constexpr const char* kFlaggedForDeleteTag = "DEL ";
     static constexpr const char* kPrivateFrameID = "PRIV";
+    static constexpr const char* kUserTextFrameID = "TXXX";
 
   public:
     ID3Frame() noexcept
@@ -110,6 +430,11 @@ private:
     {
     }
 
+    ID3Frame( RawFramePtr f, uint8_t majorVersion, bool isTagUnsynced ) noexcept
+      : rawFrame( f ), encodedVersion( majorVersion ), isTagUnsynchronized( isTagUnsynced )
+    {
+    }
+
     ID3Frame( const ID3Frame& ) = default; // may allocate; can't be noexcept
     ID3Frame& operator=( const ID3Frame& ) noexcept = delete;
     ID3Frame( ID3Frame&& ) noexcept = default;
@@ -119,12 +444,33 @@ private:
     {
       switch( newFrame.size() )
       {
-      case 0:                 return rawFrame;
+      case 0:                 return encodedVersion ? GetDecodedFrame() : rawFrame;
       case kFlaggedForDelete: return rawFrame;
       default:                return newFrame.data();
       }
     }
 
+    const uint8_t* GetDecodedFrame() const;
+
+    bool Decode() // decode now; if it can't be inflated, keep rawFrame as-is
+    {
+      if( BuildDecodedFrame() )
+        return true;
+      decodedFrame.clear();
+      encodedVersion = 0u;
+      return false;
+    }
+
+    bool IsEncoded() const // GetData() returns a decoded copy of rawFrame
+    {
+      return encodedVersion != 0u;
+    }
+
+    const uint8_t* GetHeader() const // frame ID and flags without decoding
+    {
+      return newFrame.size() > kFlaggedForDelete ? newFrame.data() : rawFrame;
+    }
+
     uint8_t* GetData() // can only modify newFrame
     {
       assert( newFrame.size() > 0 );
@@ -146,7 +492,7 @@ private:
 
     bool IsTextFrame() const // all ID3 text frames start w/ T
     {
-      return ( *GetData() == 'T' );
+      return ( *GetHeader() == 'T' );
     }
 
     bool IsFrameID( Mp3FrameType frameType ) const
@@ -164,6 +510,11 @@ private:
       return this->GetFrameID() == kPrivateFrameID;
     }
 
+    bool IsUserTextFrame() const
+    {
+      return this->GetFrameID() == kUserTextFrameID;
+    }
+
     void Allocate( size_t size ) // prepare newFrame to receive data
     {
       newFrame.resize( size );
@@ -174,6 +525,11 @@ private:
       return( ( newFrame.size() > 0 ) && ( newFrame.size() != kFlaggedForDelete ) );
     }
 
+    bool IsDeleted() const
+    {
+      return newFrame.size() == kFlaggedForDelete;
+    }
+
     void FlagToDelete() // remove this frame from storage
     {
       newFrame.resize( kFlaggedForDelete );
@@ -184,7 +540,7 @@ private:
       uint32_t newFrameSize = static_cast<uint32_t>( newFrame.size() );
       switch( newFrameSize )
       {
-      case 0:                 return GetFrameBytes( rawFrame, version ); // orig frame
+      case 0:                 return GetFrameBytes( GetData(), version ); // orig frame, decoded if needed
       case kFlaggedForDelete: return 0u;
       default:                return newFrameSize;
       }
@@ -195,14 +551,24 @@ private:
   //
   // APE tag manager
   // 
-  // APE tags currently treated as read-only.
-  // Safe to cast GetData() to const APEv2TagItem*
+  // rawTag is the tag item from the MP3 file; nullptr indicates a new item.
+  // rawTag points into the internal buffer managed by apeFrameBuffer_.
+  //
+  // newTag is a new or updated item; it supercedes rawTag when it has
+  // size > 1; size == 1 (kFlaggedForDelete) means item flagged for delete.
+  //
+  // Safe to cast GetData() to APEv2TagItem*
 
   struct APETag
   {
   private:
     using RawTagPtr = const uint8_t*;
+    using TagBuf = std::vector<uint8_t>;
+
     RawTagPtr rawTag = nullptr;
+    TagBuf    newTag;
+
+    static constexpr uint32_t kFlaggedForDelete = 1;
 
   public:
     APETag() noexcept
@@ -214,32 +580,102 @@ private:
     {
     }
 
-    APETag(const APETag&) noexcept = default;
-    APETag& operator=(const APETag&) noexcept = delete;
-    APETag(APETag&&) noexcept = default;
-    APETag& operator=(APETag&&) noexcept = default;
+    APETag( const APETag& ) = default; // may allocate; can't be noexcept
+    APETag& operator=( const APETag& ) noexcept = delete;
+    APETag( APETag&& ) noexcept = default;
+    APETag& operator=( APETag&& ) noexcept = default;
+
+    const uint8_t* GetData() const // select the most relevant data
+    {
+      switch( newTag.size() )
+      {
+      case 0:                 return rawTag;
+      case kFlaggedForDelete: return rawTag;
+      default:                return newTag.data();
+      }
+    }
+
+    uint8_t* GetData() // can only modify newTag
+    {
+      assert( newTag.size() > 0 );
+      assert( newTag.size() != kFlaggedForDelete );
+      return newTag.data();
+    }
 
-    const uint8_t* GetData() const
+    void Allocate( size_t size ) // prepare newTag to receive data
     {
-      // safe to cast to APEv2TagItem
-      return rawTag;
+      newTag.resize( size );
+    }
+
+    bool IsDeleted() const
+    {
+      return newTag.size() == kFlaggedForDelete;
+    }
+
+    void FlagToDelete() // remove this item from storage
+    {
+      newTag.resize( kFlaggedForDelete );
+    }
+
+    uint32_t GetWriteBytes() const // # bytes to write
+    {
+      uint32_t newTagSize = static_cast<uint32_t>( newTag.size() );
+      switch( newTagSize )
+      {
+      case 0:                 return GetAPETagBytes( rawTag ); // orig item
+      case kFlaggedForDelete: return 0u;
+      default:                return newTagSize;
+      }
     }
 
   }; // APETag
 
+  ///////////////////////////////////////////////////////////////////////////
+  //
+  // APE keys are ASCII and compared without regard to case
+  // See https://mutagen-specs.readthedocs.io/en/latest/apev2/apev2.html#item-key
+
+  using APEKeyHash = CaseInsensitiveHash;
+  using APEKeyEqual = CaseInsensitiveEqual;
+
+  // Case-sensitive hash for std::string keys looked up by string_view
+  struct StringViewHash
+  {
+    using is_transparent = void;
+
+    size_t operator()( std::string_view str ) const noexcept
+    {
+      return std::hash<std::string_view>{}( str );
+    }
+  };
+
 private:
 
-  uint64_t FindApeHeaderOffset( File& ) const;
+  bool LoadTail( File& );
 
   const ID3Frame* GetTextFrame( Mp3FrameType ) const;
   size_t GetTextFrameReferencePos( Mp3FrameType ) const;
 
+  void ClearIndexes();
+  void IndexAPEFields();
+  std::string GetSourceText( Mp3TagSource, Mp3FrameType ) const;
+
+  const APETag* GetAPETag( std::string_view key ) const;
+  void SetAPEItem( std::string_view key, std::span<const uint8_t> value, bool isBinary );
+  void DeleteAPETag( std::string_view key );
+
+  bool IsOpaqueFrame( const ID3Frame& ) const;
   const ID3Frame* GetCommentFrame( size_t index ) const;
   size_t GetCommentFrameReferencePos( size_t index ) const;
 
   void DeleteTextFrame( Mp3FrameType );
   void DeleteCommentFrame( size_t index );
 
+  bool ScanSeekTable( uint32_t framesPerEntry );
+  bool GetiTunesGaplessInfo( Mp3GaplessInfo& ) const;
+  static bool HashFileRange( const std::filesystem::path&, uint64_t start, uint64_t end,
+                             uint64_t& hash );
+
   friend std::ostream& operator<<( std::ostream&, const Mp3TagData& );
 
 private:
@@ -253,12 +689,85 @@ private:
   std::vector<APETag>   apeTags_;        // list of all APE tags
 
   using FramePos = size_t;               // index into mFrames
-  std::vector<FramePos>  textFrames_;    // list of all text frames (subset of mFrames)
+  static constexpr FramePos kInvalidFramePos = FramePos( -1 );
+  std::array<FramePos, kMaxFrameTypes> textFrameIndex_; // frame type -> frames_ position
+
+  struct NumericField
+  {
+    uint32_t value = 0u;
+    uint32_t total = 0u; // TRCK only
+    bool isValid = false;
+  };
+  std::array<NumericField, kMaxFrameTypes> numericFields_; // parsed numeric text frames
   std::vector<FramePos>  commentFrames_; // list of all comment frames (subset of mFrames)
+  mutable std::array<std::optional<std::string>, kMaxFrameTypes> textCache_; // decoded GetText() values
+  mutable std::vector<std::optional<std::string>> commentCache_; // decoded GetComment() values
+  using CommentIndex = std::unordered_multimap<std::string, FramePos, StringViewHash, std::equal_to<>>;
+  CommentIndex commentIndex_;            // UTF-8 description -> frames_ position
+  using UserTextIndex = std::unordered_map<std::string, FramePos, APEKeyHash, APEKeyEqual>;
+  UserTextIndex userTextIndex_;          // UTF-8 TXXX description, any case -> frames_ position
+
+  using TagPos = size_t;                 // index into apeTags_
+  using APEIndex = std::unordered_map<std::string_view, TagPos, APEKeyHash, APEKeyEqual>;
+  APEIndex apeIndex_;                    // APE key (view into tag data) -> apeTags_ position
+  std::array<TagPos, kMaxFrameTypes> apeFieldIndex_; // frame type -> apeTags_ position
+  Mp3FrameOrder frameOrder_ = Mp3FrameOrder::Preserve;
+  SourceOrder sourceOrder_ = { Mp3TagSource::ID3v2, Mp3TagSource::APE, Mp3TagSource::ID3v1 };
+  uint64_t apeStart_ = 0u;               // file offset of APE header
+  uint64_t audioEndOffset_ = 0u;         // file offset of APE/ID3v1 tail
+  ID3v1Tag id3v1Tag_;
+  MpegAudioInfo audioInfo_;              // populated by LoadAudioInfo()
+  MpegSeekTable seekTable_;              // populated by BuildSeekTable()
+  Mp3GaplessInfo gaplessInfo_;           // populated by LoadGaplessInfo()
+  ID3v2SyncedText syncedText_;           // populated by LoadSyncedText()
+  ID3v2Chapters chapters_;               // populated by LoadChapters()
+  bool hasID3v1_ = false;
   bool isDirty_ = false;
+  bool isTailDirty_ = false;
+
+  static InflateFunction inflateFunction_; // see SetInflateFunction()
 
 }; // end class Mp3TagData
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// Template definitions
+
+template <Mp3FrameType kFrameType>
+const std::string& Mp3TagData::GetText() const
+{
+  static_assert( kFrameType > Mp3FrameType::None && kFrameType < Mp3FrameType::Max );
+  static_assert( IsTextFrame( kFrameType ) || IsCommentFrame( kFrameType ) );
+
+  if constexpr( IsCommentFrame( kFrameType ) )
+  {
+    if( commentFrames_.empty() )
+    {
+      static const std::string kNoComment;
+      return kNoComment;
+    }
+    return GetCommentRef( 0 );
+  }
+  else
+  {
+    constexpr size_t kSlot = static_cast<size_t>( kFrameType );
+    auto& cachedText = textCache_[ kSlot ];
+    if( cachedText )
+      return *cachedText;
+
+    FramePos framePos = textFrameIndex_[ kSlot ];
+    if( framePos == kInvalidFramePos )
+    {
+      cachedText = GetID3v1Text( kFrameType ); // empty if no ID3v1 tag either
+      return *cachedText;
+    }
+
+    const auto* textFrame = reinterpret_cast<const ID3v2TextFrame*>( frames_[ framePos ].GetData() );
+    cachedText = textFrame->GetText( fileHeader_.GetMajorVersion() );
+    return *cachedText;
+  }
+}
+
 } // end namespace PKIsensee
 
 ///////////////////////////////////////////////////////////////////////////////
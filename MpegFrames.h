@@ -0,0 +1,714 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  MpegFrames.h
+//
+//  Copyright  Pete Isensee (PKIsensee@msn.com).
+//  All rights reserved worldwide.
+//
+//  Permission to copy, modify, reproduce or redistribute this source code is
+//  granted provided the above copyright notice is retained in the resulting 
+//  source code.
+// 
+//  This software is provided "as is" and without any express or implied
+//  warranties.
+//
+//  MPEG audio frame header and the informational headers (Xing/Info, VBRI,
+//  LAME) that encoders embed in the first frame of the audio stream.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace // anonymous
+{
+
+static constexpr const char* kXingID = "Xing"; // VBR
+static constexpr const char* kInfoID = "Info"; // CBR; same layout as Xing
+static constexpr const char* kVbriID = "VBRI"; // Fraunhofer VBR
+static constexpr size_t      kMpegIDCharCount = 4;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Fields in MPEG headers are big endian and not necessarily aligned, so
+// they're assembled a byte at a time
+
+inline uint32_t ReadMpegInt32( const uint8_t* p )
+{
+  return ( uint32_t( p[ 0 ] ) << 24 ) | ( uint32_t( p[ 1 ] ) << 16 ) |
+         ( uint32_t( p[ 2 ] ) << 8 ) | uint32_t( p[ 3 ] );
+}
+
+} // anonymous
+
+namespace PKIsensee
+{
+
+enum class MpegVersion
+{
+  V1 = 0,  // MPEG-1
+  V2 = 1,  // MPEG-2 LSF
+  V25 = 2, // MPEG-2.5 unofficial extension
+  Max
+};
+
+enum class MpegChannelMode
+{
+  Stereo = 0,
+  JointStereo = 1,
+  DualChannel = 2,
+  Mono = 3
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// MPEG audio frame header
+//
+// See http://mpgedit.org/mpgedit/mpeg_format/mpeghdr.htm
+//
+// AAAAAAAA AAABBCCD EEEEFFGH IIJJKLMM
+// A sync, B version, C layer, D protection, E bitrate, F sample rate,
+// G padding, H private, I channel mode, J mode extension, K copyright,
+// L original, M emphasis
+
+class MpegFrameHdr
+{
+private:
+
+  uint32_t header_ = 0u; // native order
+
+  static constexpr uint32_t kSyncMask = 0xFFE00000;
+
+  // Bitrates in kbps; [version V1 or V2/V2.5][layer-1][index]
+  static constexpr uint16_t kBitrates[ 2 ][ 3 ][ 16 ] =
+  {
+    {
+      { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 },
+      { 0, 32, 48, 56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 384, 0 },
+      { 0, 32, 40, 48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 0 }
+    },
+    {
+      { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0 },
+      { 0,  8, 16, 24, 32, 40, 48,  56,  64,  80,  96, 112, 128, 144, 160, 0 },
+      { 0,  8, 16, 24, 32, 40, 48,  56,  64,  80,  96, 112, 128, 144, 160, 0 }
+    }
+  };
+
+  // Sample rates in Hz; [MpegVersion][index]
+  static constexpr uint32_t kSampleRates[ 3 ][ 4 ] =
+  {
+    { 44100, 48000, 32000, 0 },
+    { 22050, 24000, 16000, 0 },
+    { 11025, 12000,  8000, 0 }
+  };
+
+  uint32_t GetBits( uint32_t shift, uint32_t mask ) const
+  {
+    return ( header_ >> shift ) & mask;
+  }
+
+public:
+
+  MpegFrameHdr() = default;
+
+  explicit MpegFrameHdr( const uint8_t* rawHeader )
+    : header_( ReadMpegInt32( rawHeader ) )
+  {
+  }
+
+  bool IsValid() const
+  {
+    if( ( header_ & kSyncMask ) != kSyncMask )
+      return false;
+    if( GetBits( 19, 0x3 ) == 0x1 ) // reserved version
+      return false;
+    if( GetBits( 17, 0x3 ) == 0x0 ) // reserved layer
+      return false;
+    auto bitrateIndex = GetBits( 12, 0xF );
+    if( bitrateIndex == 0x0 || bitrateIndex == 0xF ) // free format or bad
+      return false;
+    if( GetBits( 10, 0x3 ) == 0x3 ) // reserved sample rate
+      return false;
+    if( GetBits( 0, 0x3 ) == 0x2 ) // reserved emphasis
+      return false;
+    return true;
+  }
+
+  // True if the other frame belongs to the same stream
+  bool IsCompatible( const MpegFrameHdr& other ) const
+  {
+    // version, layer and sample rate never change mid-stream
+    constexpr uint32_t kStreamMask = 0xFFFE0C00;
+    return ( header_ & kStreamMask ) == ( other.header_ & kStreamMask );
+  }
+
+  MpegVersion GetVersion() const
+  {
+    switch( GetBits( 19, 0x3 ) )
+    {
+    case 0x3: return MpegVersion::V1;
+    case 0x2: return MpegVersion::V2;
+    default:  return MpegVersion::V25;
+    }
+  }
+
+  uint32_t GetLayer() const // 1, 2 or 3
+  {
+    return 4 - GetBits( 17, 0x3 );
+  }
+
+  bool HasCRC() const
+  {
+    return GetBits( 16, 0x1 ) == 0;
+  }
+
+  uint32_t GetBitrate() const // kbps
+  {
+    assert( IsValid() );
+    auto versionIndex = ( GetVersion() == MpegVersion::V1 ) ? 0u : 1u;
+    return kBitrates[ versionIndex ][ GetLayer() - 1 ][ GetBits( 12, 0xF ) ];
+  }
+
+  uint32_t GetSampleRate() const // Hz
+  {
+    assert( IsValid() );
+    return kSampleRates[ static_cast<size_t>( GetVersion() ) ][ GetBits( 10, 0x3 ) ];
+  }
+
+  bool HasPadding() const
+  {
+    return GetBits( 9, 0x1 ) != 0;
+  }
+
+  MpegChannelMode GetChannelMode() const
+  {
+    return static_cast<MpegChannelMode>( GetBits( 6, 0x3 ) );
+  }
+
+  uint32_t GetSamplesPerFrame() const
+  {
+    if( GetLayer() == 1 )
+      return 384;
+    if( GetLayer() == 2 || GetVersion() == MpegVersion::V1 )
+      return 1152;
+    return 576; // Layer III, MPEG-2 and 2.5
+  }
+
+  uint32_t GetFrameBytes() const // including the header
+  {
+    assert( IsValid() );
+    uint32_t bitsPerSecond = GetBitrate() * 1000;
+    uint32_t padding = HasPadding() ? 1u : 0u;
+    if( GetLayer() == 1 )
+      return ( ( 12 * bitsPerSecond / GetSampleRate() ) + padding ) * 4; // 4-byte slots
+    uint32_t bytesPerSample = GetSamplesPerFrame() / 8;
+    return ( bytesPerSample * bitsPerSecond / GetSampleRate() ) + padding;
+  }
+
+  // Offset from the frame start where a Xing/Info header would begin
+  uint32_t GetXingOffset() const
+  {
+    uint32_t offset = sizeof( header_ ) + ( HasCRC() ? 2u : 0u );
+    bool isMono = ( GetChannelMode() == MpegChannelMode::Mono );
+    if( GetVersion() == MpegVersion::V1 )
+      return offset + ( isMono ? 17u : 32u ); // Layer III side info
+    return offset + ( isMono ? 9u : 17u );
+  }
+
+  // Offset from the frame start where a VBRI header would begin
+  static constexpr uint32_t GetVbriOffset()
+  {
+    return sizeof( header_ ) + 32u;
+  }
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Locate the next candidate frame sync (11 set bits) in [start, end)
+//
+// memchr is vectorized by the C runtime, so runs of junk or zero padding in
+// front of the audio are skipped at memory bandwidth
+
+inline const uint8_t* FindMpegSync( const uint8_t* start, const uint8_t* end )
+{
+  for( const uint8_t* p = start; end - p >= 2; ++p )
+  {
+    p = static_cast<const uint8_t*>( memchr( p, 0xFF, static_cast<size_t>( end - p - 1 ) ) );
+    if( p == nullptr )
+      return nullptr;
+    if( ( p[ 1 ] & 0xE0 ) == 0xE0 )
+      return p;
+  }
+  return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Xing/Info header
+//
+// See https://www.codeproject.com/Articles/8295/MPEG-Audio-Frame-Header#XINGHeader
+// "Xing" marks VBR streams, "Info" marks CBR streams; the layout is identical
+
+class MpegXingHdr
+{
+public:
+
+  static constexpr size_t kTocEntries = 100;
+
+private:
+
+  static constexpr uint32_t kFlagFrames  = ( 1 << 0 );
+  static constexpr uint32_t kFlagBytes   = ( 1 << 1 );
+  static constexpr uint32_t kFlagToc     = ( 1 << 2 );
+  static constexpr uint32_t kFlagQuality = ( 1 << 3 );
+
+  bool     isValid_ = false;
+  bool     isVbr_ = false;
+  uint32_t flags_ = 0u;
+  uint32_t frameCount_ = 0u;
+  uint32_t byteCount_ = 0u;
+  std::array<uint8_t, kTocEntries> toc_ = {};
+  uint32_t headerBytes_ = 0u;
+
+public:
+
+  MpegXingHdr() = default;
+
+  // rawXing points at the "Xing"/"Info" ID; available is the number of bytes that follow
+  MpegXingHdr( const uint8_t* rawXing, size_t available )
+  {
+    constexpr size_t kMinBytes = kMpegIDCharCount + sizeof( uint32_t );
+    if( available < kMinBytes )
+      return;
+    isVbr_ = ( memcmp( rawXing, kXingID, kMpegIDCharCount ) == 0 );
+    if( !isVbr_ && memcmp( rawXing, kInfoID, kMpegIDCharCount ) != 0 )
+      return;
+
+    flags_ = ReadMpegInt32( rawXing + kMpegIDCharCount );
+    size_t needed = kMinBytes;
+    needed += ( flags_ & kFlagFrames )  ? sizeof( uint32_t ) : 0u;
+    needed += ( flags_ & kFlagBytes )   ? sizeof( uint32_t ) : 0u;
+    needed += ( flags_ & kFlagToc )     ? kTocEntries : 0u;
+    needed += ( flags_ & kFlagQuality ) ? sizeof( uint32_t ) : 0u;
+    if( available < needed )
+      return;
+
+    const uint8_t* p = rawXing + kMinBytes;
+    if( flags_ & kFlagFrames )
+    {
+      frameCount_ = ReadMpegInt32( p );
+      p += sizeof( uint32_t );
+    }
+    if( flags_ & kFlagBytes )
+    {
+      byteCount_ = ReadMpegInt32( p );
+      p += sizeof( uint32_t );
+    }
+    if( flags_ & kFlagToc )
+      memcpy( toc_.data(), p, kTocEntries );
+    headerBytes_ = static_cast<uint32_t>( needed );
+    isValid_ = true;
+  }
+
+  bool IsValid() const
+  {
+    return isValid_;
+  }
+
+  bool IsVbr() const
+  {
+    return isVbr_;
+  }
+
+  bool HasFrameCount() const
+  {
+    return !!( flags_ & kFlagFrames );
+  }
+
+  bool HasByteCount() const
+  {
+    return !!( flags_ & kFlagBytes );
+  }
+
+  bool HasToc() const
+  {
+    return !!( flags_ & kFlagToc );
+  }
+
+  uint32_t GetFrameCount() const
+  {
+    return frameCount_;
+  }
+
+  uint32_t GetByteCount() const
+  {
+    return byteCount_;
+  }
+
+  // Entry i is the file position, in 1/256ths of the audio size, at i percent of the duration
+  const std::array<uint8_t, kTocEntries>& GetToc() const
+  {
+    return toc_;
+  }
+
+  // Bytes from the "Xing" ID to the end of the header; the LAME header follows
+  uint32_t GetHeaderBytes() const
+  {
+    return headerBytes_;
+  }
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// VBRI header (Fraunhofer encoder)
+//
+// See https://www.codeproject.com/Articles/8295/MPEG-Audio-Frame-Header#VBRIHeader
+
+class MpegVbriHdr
+{
+private:
+
+  bool     isValid_ = false;
+  uint32_t frameCount_ = 0u;
+  uint32_t byteCount_ = 0u;
+
+public:
+
+  MpegVbriHdr() = default;
+
+  // rawVbri points at the "VBRI" ID; available is the number of bytes that follow
+  MpegVbriHdr( const uint8_t* rawVbri, size_t available )
+  {
+    // ID, version, delay, quality, bytes, frames
+    constexpr size_t kMinBytes = kMpegIDCharCount + 2 + 2 + 2 + 4 + 4;
+    if( available < kMinBytes || memcmp( rawVbri, kVbriID, kMpegIDCharCount ) != 0 )
+      return;
+    byteCount_ = ReadMpegInt32( rawVbri + 10 );
+    frameCount_ = ReadMpegInt32( rawVbri + 14 );
+    isValid_ = true;
+  }
+
+  bool IsValid() const
+  {
+    return isValid_;
+  }
+
+  uint32_t GetFrameCount() const
+  {
+    return frameCount_;
+  }
+
+  uint32_t GetByteCount() const
+  {
+    return byteCount_;
+  }
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// LAME extension to the Xing/Info header
+//
+// See http://gabriel.mp3-tech.org/mp3infotag.html
+
+class MpegLameHdr
+{
+public:
+
+  static constexpr size_t kEncoderChars = 9; // e.g. "LAME3.100"
+
+private:
+
+  static constexpr size_t kLameHdrBytes = 36;
+  static constexpr size_t kDelayPaddingPos = 21; // 12 bits delay, 12 bits padding
+
+  bool     isValid_ = false;
+  char     encoder_[ kEncoderChars ] = {};
+  uint16_t encoderDelay_ = 0u;
+  uint16_t encoderPadding_ = 0u;
+
+public:
+
+  MpegLameHdr() = default;
+
+  // rawLame points immediately after the Xing/Info header
+  MpegLameHdr( const uint8_t* rawLame, size_t available )
+  {
+    if( available < kLameHdrBytes )
+      return;
+
+    // Written by LAME and by encoders built on it (e.g. "Lavf", "Lavc" from FFmpeg)
+    if( memcmp( rawLame, "LAME", 4 ) != 0 && memcmp( rawLame, "Lav", 3 ) != 0 &&
+        memcmp( rawLame, "L3.9", 4 ) != 0 && memcmp( rawLame, "GOGO", 4 ) != 0 )
+      return;
+
+    memcpy( encoder_, rawLame, kEncoderChars );
+    const uint8_t* dp = rawLame + kDelayPaddingPos;
+    encoderDelay_ = static_cast<uint16_t>( ( dp[ 0 ] << 4 ) | ( dp[ 1 ] >> 4 ) );
+    encoderPadding_ = static_cast<uint16_t>( ( ( dp[ 1 ] & 0x0F ) << 8 ) | dp[ 2 ] );
+    isValid_ = true;
+  }
+
+  bool IsValid() const
+  {
+    return isValid_;
+  }
+
+  std::string GetEncoder() const
+  {
+    std::string encoder( encoder_, kEncoderChars );
+    while( !encoder.empty() && ( encoder.back() == ' ' || encoder.back() == '\0' ) )
+      encoder.pop_back();
+    return encoder;
+  }
+
+  uint16_t GetEncoderDelay() const // samples
+  {
+    return encoderDelay_;
+  }
+
+  uint16_t GetEncoderPadding() const // samples
+  {
+    return encoderPadding_;
+  }
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Summary of an MPEG audio stream, as determined from its first frames
+
+struct MpegAudioInfo
+{
+  MpegVersion     version = MpegVersion::V1;
+  uint32_t        layer = 0u;            // 1, 2 or 3
+  uint32_t        sampleRate = 0u;       // Hz
+  MpegChannelMode channelMode = MpegChannelMode::Stereo;
+  uint32_t        bitrate = 0u;          // kbps; average bitrate for VBR
+  uint32_t        samplesPerFrame = 0u;
+  bool            isVbr = false;
+  bool            isExact = false;       // frame count from Xing/Info/VBRI rather than estimated
+  uint32_t        frameCount = 0u;       // audio frames, excluding any Xing/Info/VBRI frame
+  uint64_t        durationMs = 0u;
+  uint64_t        firstFrameOffset = 0u; // file offset of first audio frame
+  uint64_t        audioBytes = 0u;       // from firstFrameOffset to the tail tags
+  std::string     encoder;               // from LAME header, e.g. "LAME3.100"
+  MpegXingHdr     xing;                  // Xing/Info header, if any
+  MpegLameHdr     lame;                  // LAME header, if any
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Time-to-byte seek table for an MPEG audio stream
+//
+// Offsets are relative to the first audio frame. A table built by scanning
+// holds the offset of every Nth frame, so a seek lands exactly on a frame
+// boundary at most N frames before the target. A table built from the Xing
+// TOC holds 100 entries, one per percent of the duration, and seeks are
+// interpolated between them.
+//
+// Serialize() output is an MpegSeekTableHdr followed by the offsets, in native byte
+// order; it's meant for a local cache, not for interchange.
+
+struct MpegSeekPoint
+{
+  uint64_t fileOffset = 0u; // start of a frame, or an estimate when from a TOC
+  uint64_t timeMs = 0u;     // time at fileOffset
+};
+
+#pragma pack(push,1) // Essential for the serialized layout
+struct MpegSeekTableHdr
+{
+  char     tableID_[ kMpegIDCharCount ]; // 'MSKT'
+  uint32_t version_;
+  uint64_t firstFrameOffset_;
+  uint64_t audioBytes_;
+  uint64_t durationMs_;
+  uint32_t sampleRate_;
+  uint32_t samplesPerFrame_;
+  uint32_t framesPerEntry_;
+  uint32_t entryCount_;
+};
+#pragma pack(pop)
+
+class MpegSeekTable
+{
+public:
+
+  static constexpr uint32_t kDefaultFramesPerEntry = 16; // ~0.4s for 44.1KHz Layer III
+
+private:
+
+  static constexpr uint32_t kTocScale = 256; // Xing TOC entries are 1/256ths of the audio
+  static constexpr uint32_t kSerializeVersion = 1;
+
+  uint64_t firstFrameOffset_ = 0u;
+  uint64_t audioBytes_ = 0u;
+  uint64_t durationMs_ = 0u;
+  uint32_t sampleRate_ = 0u;
+  uint32_t samplesPerFrame_ = 0u;
+  uint32_t framesPerEntry_ = 0u; // zero when built from a Xing TOC
+  std::vector<uint32_t> offsets_;
+
+public:
+
+  MpegSeekTable() = default;
+
+  // Begin a table for a scan of the stream; add one entry per framesPerEntry frames
+  void InitScan( uint64_t firstFrameOffset, uint64_t audioBytes, uint32_t sampleRate,
+                 uint32_t samplesPerFrame, uint32_t framesPerEntry )
+  {
+    assert( framesPerEntry != 0 );
+    *this = MpegSeekTable{};
+    firstFrameOffset_ = firstFrameOffset;
+    audioBytes_ = audioBytes;
+    sampleRate_ = sampleRate;
+    samplesPerFrame_ = samplesPerFrame;
+    framesPerEntry_ = framesPerEntry;
+  }
+
+  // frameOffset is relative to the first audio frame
+  void AddEntry( uint32_t frameOffset )
+  {
+    offsets_.push_back( frameOffset );
+  }
+
+  // Complete a scanned table once the total frame count is known
+  void SetFrameCount( uint32_t frameCount )
+  {
+    durationMs_ = uint64_t( frameCount ) * samplesPerFrame_ * 1000u / sampleRate_;
+  }
+
+  // Build the table from the Xing TOC; requires HasToc() and an exact duration
+  void InitFromToc( uint64_t firstFrameOffset, uint64_t audioBytes, uint64_t durationMs,
+                    const MpegXingHdr& xing )
+  {
+    assert( xing.HasToc() );
+    *this = MpegSeekTable{};
+    firstFrameOffset_ = firstFrameOffset;
+    audioBytes_ = audioBytes;
+    durationMs_ = durationMs;
+    offsets_.reserve( MpegXingHdr::kTocEntries );
+    for( uint8_t entry : xing.GetToc() )
+      offsets_.push_back( static_cast<uint32_t>( entry * audioBytes / kTocScale ) );
+  }
+
+  bool IsEmpty() const
+  {
+    return offsets_.empty() || durationMs_ == 0u;
+  }
+
+  bool IsFromToc() const
+  {
+    return framesPerEntry_ == 0u;
+  }
+
+  size_t GetEntryCount() const
+  {
+    return offsets_.size();
+  }
+
+  uint64_t GetDurationMs() const
+  {
+    return durationMs_;
+  }
+
+  // True if the table was built for a stream at this position and size; a
+  // cached table is stale if the tags or audio were rewritten since
+  bool IsMatch( uint64_t firstFrameOffset, uint64_t audioBytes ) const
+  {
+    return firstFrameOffset_ == firstFrameOffset && audioBytes_ == audioBytes;
+  }
+
+  // File offset to begin streaming from to play from timeMs
+  MpegSeekPoint Seek( uint64_t timeMs ) const
+  {
+    assert( !IsEmpty() );
+    if( timeMs >= durationMs_ )
+      return { firstFrameOffset_ + audioBytes_, durationMs_ };
+
+    if( IsFromToc() )
+    {
+      // Linear interpolation between percentage points
+      uint64_t scaledPos = timeMs * MpegXingHdr::kTocEntries;
+      auto entry = static_cast<size_t>( scaledPos / durationMs_ );
+      uint64_t lower = offsets_[ entry ];
+      uint64_t upper = ( entry + 1 < offsets_.size() ) ? offsets_[ entry + 1 ] : audioBytes_;
+      uint64_t offset = lower + ( ( upper - lower ) * ( scaledPos % durationMs_ ) ) / durationMs_;
+      return { firstFrameOffset_ + offset, timeMs };
+    }
+
+    uint64_t samplesPerEntry = uint64_t( samplesPerFrame_ ) * framesPerEntry_;
+    uint64_t entry = ( timeMs * sampleRate_ ) / ( 1000u * samplesPerEntry );
+    if( entry >= offsets_.size() )
+      entry = offsets_.size() - 1;
+    uint64_t entryTimeMs = ( entry * samplesPerEntry * 1000u ) / sampleRate_;
+    return { firstFrameOffset_ + offsets_[ static_cast<size_t>( entry ) ], entryTimeMs };
+  }
+
+  void Serialize( std::vector<uint8_t>& out ) const
+  {
+    MpegSeekTableHdr hdr;
+    memcpy( hdr.tableID_, "MSKT", kMpegIDCharCount );
+    hdr.version_ = kSerializeVersion;
+    hdr.firstFrameOffset_ = firstFrameOffset_;
+    hdr.audioBytes_ = audioBytes_;
+    hdr.durationMs_ = durationMs_;
+    hdr.sampleRate_ = sampleRate_;
+    hdr.samplesPerFrame_ = samplesPerFrame_;
+    hdr.framesPerEntry_ = framesPerEntry_;
+    hdr.entryCount_ = static_cast<uint32_t>( offsets_.size() );
+
+    size_t offsetBytes = offsets_.size() * sizeof( uint32_t );
+    out.resize( sizeof( hdr ) + offsetBytes );
+    memcpy( out.data(), &hdr, sizeof( hdr ) );
+    if( offsetBytes )
+      memcpy( out.data() + sizeof( hdr ), offsets_.data(), offsetBytes );
+  }
+
+  bool Deserialize( std::span<const uint8_t> in )
+  {
+    MpegSeekTableHdr hdr;
+    if( in.size() < sizeof( hdr ) )
+      return false;
+    memcpy( &hdr, in.data(), sizeof( hdr ) );
+    if( memcmp( hdr.tableID_, "MSKT", kMpegIDCharCount ) != 0 || hdr.version_ != kSerializeVersion )
+      return false;
+    size_t offsetBytes = size_t( hdr.entryCount_ ) * sizeof( uint32_t );
+    if( in.size() - sizeof( hdr ) != offsetBytes )
+      return false;
+    if( hdr.framesPerEntry_ != 0u && ( hdr.sampleRate_ == 0u || hdr.samplesPerFrame_ == 0u ) )
+      return false;
+
+    // Seek() indexes by time, so the table shape must match how it was built;
+    // a TOC table always has one entry per percentage point
+    if( hdr.entryCount_ == 0u || hdr.durationMs_ == 0u )
+      return false;
+    if( hdr.framesPerEntry_ == 0u && hdr.entryCount_ != MpegXingHdr::kTocEntries )
+      return false;
+
+    firstFrameOffset_ = hdr.firstFrameOffset_;
+    audioBytes_ = hdr.audioBytes_;
+    durationMs_ = hdr.durationMs_;
+    sampleRate_ = hdr.sampleRate_;
+    samplesPerFrame_ = hdr.samplesPerFrame_;
+    framesPerEntry_ = hdr.framesPerEntry_;
+    offsets_.resize( hdr.entryCount_ );
+    if( offsetBytes )
+      memcpy( offsets_.data(), in.data() + sizeof( hdr ), offsetBytes );
+    return true;
+  }
+
+};
+
+} // namespace PKIsensee
+
+///////////////////////////////////////////////////////////////////////////////